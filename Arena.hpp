@@ -0,0 +1,614 @@
+#pragma once
+
+#include "ChunkedBoard.hpp"
+#include "Game.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+// Many snakes on one runtime-sized board, all moving at once. Every tick each
+// living snake first lets go of its tail, then claims the cell in front of it by
+// adding to that cell's body count. A head has survived when its cell holds
+// exactly its own claim. A second claim in that cell is either another head
+// (head to head: both die) or a body (the snake that moved into it dies).
+// Collisions are read from the shared board and never tested pair by pair, so a
+// tick costs time linear in the number of snakes and the result does not depend
+// on the order they are stored in.
+class Arena
+{
+public:
+    Arena(int width, int height, uint64_t seed = 0) :
+        _board(width, height),
+        _regions(size_t((height + RegionRows(height) - 1) / RegionRows(height))),
+        _regionRows(RegionRows(height)),
+        _random(seed),
+        _tickCount(0),
+        _alive(0)
+    {
+        for (auto& region : _regions)
+        {
+            region.outbox.resize(_regions.size());
+        }
+    }
+
+    int Width() const
+    {
+        return int(_board.Width());
+    }
+
+    int Height() const
+    {
+        return int(_board.Height());
+    }
+
+    bool IsBorder(int x, int y) const
+    {
+        return x == 0 || x == Width() - 1 || y == 0 || y == Height() - 1;
+    }
+
+    // True for the border and beyond, any snake and bad obstacles
+    bool IsBlocked(const Coordinates& c) const
+    {
+        return !_board.InBounds(c.first, c.second) || IsBorder(c.first, c.second) ||
+               (_board.Get(c.first, c.second) & (BodyMask | Bad));
+    }
+
+    bool IsBody(const Coordinates& c) const
+    {
+        return _board.Get(c.first, c.second) & BodyMask;
+    }
+
+    bool IsGood(const Coordinates& c) const
+    {
+        return _board.Get(c.first, c.second) & Good;
+    }
+
+    bool IsBad(const Coordinates& c) const
+    {
+        return _board.Get(c.first, c.second) & Bad;
+    }
+
+    const ChunkedBoard& Board() const
+    {
+        return _board;
+    }
+
+    // True if a snake of this length fits with its head here and its body trailing
+    // away from direction
+    bool CanPlace(const Coordinates& head, Direction direction, int length = 5) const
+    {
+        auto c = head;
+
+        for (int n = 0; n < length; n++)
+        {
+            if (IsBlocked(c) || IsGood(c))
+            {
+                return false;
+            }
+
+            Step(c, Opposite(direction));
+        }
+
+        return true;
+    }
+
+    // Returns the id of the new snake, which stays valid after it dies
+    size_t AddSnake(const Coordinates& head, Direction direction, int length = 5)
+    {
+        if (length < 1 || !CanPlace(head, direction, length))
+        {
+            throw std::invalid_argument("Snake does not fit");
+        }
+
+        Player player;
+        player.direction = direction;
+        auto c = head;
+
+        for (int n = 0; n < length; n++)
+        {
+            player.body.push_back(c);
+            Change(c, 1);
+            Step(c, Opposite(direction));
+        }
+
+        _players.push_back(std::move(player));
+        _alive++;
+        return _players.size() - 1;
+    }
+
+    size_t SnakeCount() const
+    {
+        return _players.size();
+    }
+
+    size_t Alive() const
+    {
+        return _alive;
+    }
+
+    bool IsAlive(size_t id) const
+    {
+        return _players[id].alive;
+    }
+
+    Direction GetDirection(size_t id) const
+    {
+        return _players[id].direction;
+    }
+
+    void SetDirection(size_t id, Direction direction)
+    {
+        _players[id].direction = direction;
+    }
+
+    // Dead snakes keep the body they died with, but it is no longer on the board
+    size_t Length(size_t id) const
+    {
+        return _players[id].body.size();
+    }
+
+    // Body(id, 0) is the head
+    Coordinates Body(size_t id, size_t n) const
+    {
+        return _players[id].body[n];
+    }
+
+    Coordinates Head(size_t id) const
+    {
+        return _players[id].body.front();
+    }
+
+    size_t Score(size_t id) const
+    {
+        return _players[id].score;
+    }
+
+    size_t ObstacleCount() const
+    {
+        return _obstacles.size();
+    }
+
+    Coordinates Obstacle(size_t n) const
+    {
+        return _obstacles[n];
+    }
+
+    size_t TickCount() const
+    {
+        return _tickCount;
+    }
+
+    // A bot for the rest of the arena: keeps going while it can, turns onto food next
+    // to its head, and otherwise picks a random open direction now and then
+    Direction Wander(size_t id, uint64_t entropy) const
+    {
+        auto& player = _players[id];
+        Direction open[4];
+        int count = 0;
+
+        for (auto direction : {Direction::North, Direction::East, Direction::South, Direction::West})
+        {
+            auto c = player.body.front();
+            Step(c, direction);
+
+            if (!IsBlocked(c))
+            {
+                if (IsGood(c))
+                {
+                    return direction;
+                }
+
+                open[count++] = direction;
+            }
+        }
+
+        if (count == 0)
+        {
+            return player.direction;
+        }
+
+        for (int n = 0; n < count; n++)
+        {
+            if (open[n] == player.direction && entropy % 8 != 0)
+            {
+                return player.direction;
+            }
+        }
+
+        return open[(entropy >> 8) % count];
+    }
+
+    void Tick()
+    {
+        auto change = [this](const Coordinates& c, int body, uint8_t clear) { Change(c, body, 0, clear); };
+        bool grow = _tickCount % 10 == 0;
+        bool eaten = false;
+        size_t dead = 0;
+
+        for (auto& player : _players)
+        {
+            if (player.alive)
+            {
+                FollowTheSnakeHead(player, grow, change);
+            }
+        }
+
+        for (auto& player : _players)
+        {
+            if (player.alive)
+            {
+                MoveTheSnakeHead(player, change);
+            }
+        }
+
+        // Every claim is on the board before any head is judged, and nothing leaves
+        // the board until every head has been judged
+        for (auto& player : _players)
+        {
+            if (player.alive)
+            {
+                eaten |= CheckCollision(player, change);
+            }
+        }
+
+        for (auto& player : _players)
+        {
+            if (player.dying)
+            {
+                RemoveTheSnake(player, change);
+                dead++;
+            }
+        }
+
+        FinishTheTick(dead, eaten);
+    }
+
+    // The same tick split over bands of rows. A snake belongs to the region its head
+    // is in when the tick starts, and only that region's worker touches it. Changes
+    // to cells in another region are posted to that region and applied between
+    // phases. Every change adds to a count or clears a flag, so the order they land
+    // in does not matter: the board after a tick is the same as after Tick(), for
+    // any number of workers.
+    void Tick(WorkerPool& pool)
+    {
+        for (auto& region : _regions)
+        {
+            region.owned.clear();
+            region.dead = 0;
+            region.eaten = false;
+        }
+
+        for (size_t id = 0; id < _players.size(); id++)
+        {
+            if (_players[id].alive)
+            {
+                _regions[RegionOf(_players[id].body.front())].owned.push_back(id);
+            }
+        }
+
+        bool grow = _tickCount % 10 == 0;
+
+        ForEachRegion(pool, [this, grow](size_t r)
+        {
+            Poster post{*this, r, true};
+
+            for (auto id : _regions[r].owned)
+            {
+                FollowTheSnakeHead(_players[id], grow, post);
+                MoveTheSnakeHead(_players[id], post);
+            }
+        });
+
+        ForEachRegion(pool, [this](size_t r) { Deliver(r); });
+
+        // Judging only reads the board, so every change it makes waits for delivery
+        ForEachRegion(pool, [this](size_t r)
+        {
+            Poster post{*this, r, false};
+
+            for (auto id : _regions[r].owned)
+            {
+                _regions[r].eaten |= CheckCollision(_players[id], post);
+            }
+        });
+
+        ForEachRegion(pool, [this](size_t r)
+        {
+            Poster post{*this, r, true};
+
+            for (auto id : _regions[r].owned)
+            {
+                if (_players[id].dying)
+                {
+                    RemoveTheSnake(_players[id], post);
+                    _regions[r].dead++;
+                }
+            }
+        });
+
+        ForEachRegion(pool, [this](size_t r) { Deliver(r); });
+
+        size_t dead = 0;
+        bool eaten = false;
+
+        for (auto& region : _regions)
+        {
+            dead += region.dead;
+            eaten |= region.eaten;
+        }
+
+        FinishTheTick(dead, eaten);
+    }
+
+private:
+    // Same cell layout as Game: a body count plus obstacle flags. A cell holds at
+    // most one body and four claims, so the count never overflows
+    static constexpr uint8_t BodyMask = 0x3F;
+    static constexpr uint8_t Good = 0x40;
+    static constexpr uint8_t Bad = 0x80;
+
+    // Enough regions to keep any pool busy, few enough that posting stays cheap
+    static constexpr int64_t MaxRegions = 64;
+
+    struct Player
+    {
+        std::deque<Coordinates> body;
+        Direction direction = Direction::North;
+        size_t growth = 0;
+        size_t score = 0;
+        bool alive = true;
+        bool dying = false;
+    };
+
+    struct Post
+    {
+        Coordinates c;
+        int8_t body;
+        uint8_t clear;
+    };
+
+    struct Region
+    {
+        std::vector<size_t> owned;
+        std::vector<std::vector<Post>> outbox;
+        size_t dead = 0;
+        bool eaten = false;
+    };
+
+    ChunkedBoard _board;
+    std::vector<Player> _players;
+    std::vector<Coordinates> _obstacles;
+    std::vector<Region> _regions;
+    int64_t _regionRows;
+    uint64_t _random;
+    size_t _tickCount;
+    size_t _alive;
+
+    // Regions are whole bands of chunks, so no two regions share a band of the board
+    static int64_t RegionRows(int64_t height)
+    {
+        auto bands = (height + ChunkedBoard::ChunkSize - 1) / ChunkedBoard::ChunkSize;
+        return (bands + MaxRegions - 1) / MaxRegions * ChunkedBoard::ChunkSize;
+    }
+
+    size_t RegionOf(const Coordinates& c) const
+    {
+        auto y = std::min(std::max(int64_t(c.second), int64_t(0)), _board.Height() - 1);
+        return size_t(y / _regionRows);
+    }
+
+    template <typename Job>
+    void ForEachRegion(WorkerPool& pool, const Job& job)
+    {
+        std::atomic<size_t> next(0);
+
+        pool.Run([this, &job, &next](size_t)
+        {
+            for (auto r = next.fetch_add(1); r < _regions.size(); r = next.fetch_add(1))
+            {
+                job(r);
+            }
+        });
+    }
+
+    // Applies changes to the region's own cells at once when direct is set, and
+    // posts everything else to the region it belongs to
+    struct Poster
+    {
+        Arena& arena;
+        size_t region;
+        bool direct;
+
+        void operator()(const Coordinates& c, int body, uint8_t clear) const
+        {
+            auto target = arena.RegionOf(c);
+
+            if (direct && target == region)
+            {
+                arena.Change(c, body, 0, clear);
+            }
+            else
+            {
+                arena._regions[region].outbox[target].push_back({c, int8_t(body), clear});
+            }
+        }
+    };
+
+    void Deliver(size_t r)
+    {
+        for (auto& source : _regions)
+        {
+            for (auto& post : source.outbox[r])
+            {
+                Change(post.c, post.body, 0, post.clear);
+            }
+
+            source.outbox[r].clear();
+        }
+    }
+
+    // splitmix64
+    uint64_t NextRandom()
+    {
+        uint64_t z = (_random += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    void Change(const Coordinates& c, int body, uint8_t set = 0, uint8_t clear = 0)
+    {
+        auto cell = _board.Get(c.first, c.second);
+        _board.Set(c.first, c.second, uint8_t(((cell + body) & ~clear) | set));
+    }
+
+    static Direction Opposite(Direction direction)
+    {
+        return Direction((int(direction) + 2) % 4);
+    }
+
+    static void Step(Coordinates& c, Direction direction)
+    {
+        switch (direction)
+        {
+            case Direction::North: c.second--; break;
+            case Direction::East:  c.first++; break;
+            case Direction::South: c.second++; break;
+            case Direction::West:  c.first--; break;
+        }
+    }
+
+    // Growth is held back as a count instead of appending cells, so a snake grows by
+    // keeping its tail where it is
+    template <typename Apply>
+    static void FollowTheSnakeHead(Player& player, bool grow, const Apply& apply)
+    {
+        player.growth += grow;
+
+        if (player.growth > 0)
+        {
+            player.growth--;
+            return;
+        }
+
+        apply(player.body.back(), -1, 0);
+        player.body.pop_back();
+    }
+
+    template <typename Apply>
+    static void MoveTheSnakeHead(Player& player, const Apply& apply)
+    {
+        auto head = player.body.front();
+        Step(head, player.direction);
+
+        player.body.push_front(head);
+        apply(head, 1, 0);
+    }
+
+    // Returns true if the snake ate
+    template <typename Apply>
+    bool CheckCollision(Player& player, const Apply& apply) const
+    {
+        auto head = player.body.front();
+        auto cell = _board.Get(head.first, head.second);
+
+        if (!_board.InBounds(head.first, head.second) || IsBorder(head.first, head.second) ||
+            (cell & BodyMask) > 1 || (cell & Bad))
+        {
+            player.dying = true;
+            return false;
+        }
+
+        if (cell & Good)
+        {
+            // Only one head can be here, or it would have more than one claim
+            apply(head, 0, Good);
+            player.score++;
+            player.growth += 5;
+            return true;
+        }
+
+        return false;
+    }
+
+    template <typename Apply>
+    static void RemoveTheSnake(Player& player, const Apply& apply)
+    {
+        for (auto& c : player.body)
+        {
+            apply(c, -1, 0);
+        }
+
+        player.dying = false;
+        player.alive = false;
+    }
+
+    void FinishTheTick(size_t dead, bool eaten)
+    {
+        _alive -= dead;
+
+        if (eaten)
+        {
+            RemoveEatenObstacles();
+        }
+
+        if (_tickCount % 30 == 0)
+        {
+            CreateObstacle();
+        }
+
+        _tickCount++;
+    }
+
+    // Food that is eaten is replaced, so the arena never runs out
+    void RemoveEatenObstacles()
+    {
+        size_t kept = 0;
+        size_t eaten = 0;
+
+        for (auto& c : _obstacles)
+        {
+            if (_board.Get(c.first, c.second) & (Good | Bad))
+            {
+                _obstacles[kept++] = c;
+            }
+            else
+            {
+                eaten++;
+            }
+        }
+
+        _obstacles.resize(kept);
+
+        for (size_t n = 0; n < eaten; n++)
+        {
+            CreateObstacle(Good);
+        }
+    }
+
+    // Obstacles only go on cells that are empty and inside the border; if the cell
+    // drawn is taken the obstacle is skipped
+    void CreateObstacle(uint8_t kind = 0)
+    {
+        auto entropy = NextRandom();
+        auto c = std::make_pair(int(entropy % uint64_t(Width())), int((entropy >> 32) % uint64_t(Height())));
+
+        if (kind == 0)
+        {
+            kind = (entropy >> 16) % 3 == 0 ? Good : Bad;
+        }
+
+        if (IsBlocked(c) || IsGood(c))
+        {
+            return;
+        }
+
+        _obstacles.push_back(c);
+        Change(c, 0, kind);
+    }
+};
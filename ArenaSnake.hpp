@@ -0,0 +1,186 @@
+#pragma once
+
+#include "Arena.hpp"
+#include "Snake.hpp"
+
+#include <deque>
+#include <memory>
+
+// An arena with the player as snake 0 and bots for everyone else. The screen is a
+// camera that follows the player, as in WorldSnake. Given workers, the arena is
+// stepped in parallel on a pool of that many threads.
+template <int screenWidth, int screenHeight, int pixelWidth, int pixelHeight>
+class ArenaSnake :
+        public olc::PixelGameEngine
+{
+public:
+    ArenaSnake(int width, int height, size_t bots, size_t workers = 0) :
+        _arena(width, height, GetTimeMs()),
+        _workers(workers > 0 ? std::make_unique<WorkerPool>(workers) : nullptr),
+        _lastTickMs(GetTimeMs()),
+        _random(GetTimeMs() | 1)
+    {
+        sAppName = "Snake Arena";
+
+        _arena.AddSnake(std::make_pair(width / 2, height / 2), Direction::North);
+
+        // Bots go wherever they fit; a crowded arena may get fewer than asked for
+        for (size_t n = 0; n < bots * 4 && _arena.SnakeCount() <= bots; n++)
+        {
+            auto entropy = NextRandom();
+            auto head = std::make_pair(int(entropy % uint64_t(width)), int((entropy >> 32) % uint64_t(height)));
+            auto direction = Direction((entropy >> 16) % 4);
+
+            if (_arena.CanPlace(head, direction))
+            {
+                _arena.AddSnake(head, direction);
+            }
+        }
+
+        if (!Construct(screenWidth, screenHeight, pixelWidth, pixelHeight))
+        {
+            throw "Could not construct snake!";
+        }
+    }
+
+    bool OnUserCreate() final override
+    {
+        DrawTheCamera();
+        return true;
+    }
+
+    bool OnUserUpdate(float) final override
+    {
+        for (auto& event : GetInputEvents())
+        {
+            HandleInput(event);
+        }
+
+        auto now = GetTimeMs();
+        if (_arena.Alive() > 0 && now - _lastTickMs > 50)
+        {
+            Tick();
+            _lastTickMs = now;
+        }
+
+        return true;
+    }
+
+private:
+    Arena _arena;
+    std::unique_ptr<WorkerPool> _workers;
+    std::deque<Direction> _turns;
+    size_t _lastTickMs;
+    uint64_t _random;
+
+    uint64_t NextRandom()
+    {
+        _random ^= _random << 13;
+        _random ^= _random >> 7;
+        _random ^= _random << 17;
+        return _random;
+    }
+
+    void HandleInput(const olc::InputEvent& event)
+    {
+        if (event.type != olc::InputEvent::KEY_DOWN)
+        {
+            return;
+        }
+
+        switch (event.nCode)
+        {
+            case olc::Key::UP:    QueueTurn(Direction::North); break;
+            case olc::Key::RIGHT: QueueTurn(Direction::East); break;
+            case olc::Key::DOWN:  QueueTurn(Direction::South); break;
+            case olc::Key::LEFT:  QueueTurn(Direction::West); break;
+            default: break;
+        }
+    }
+
+    void QueueTurn(Direction direction)
+    {
+        auto last = _turns.empty() ? _arena.GetDirection(0) : _turns.back();
+
+        if (direction != last && _turns.size() < 3)
+        {
+            _turns.push_back(direction);
+        }
+    }
+
+    void Tick()
+    {
+        if (!_turns.empty())
+        {
+            _arena.SetDirection(0, _turns.front());
+            _turns.pop_front();
+        }
+
+        for (size_t id = 1; id < _arena.SnakeCount(); id++)
+        {
+            if (_arena.IsAlive(id))
+            {
+                _arena.SetDirection(id, _arena.Wander(id, NextRandom()));
+            }
+        }
+
+        if (_workers)
+        {
+            _arena.Tick(*_workers);
+        }
+        else
+        {
+            _arena.Tick();
+        }
+
+        DrawTheCamera();
+    }
+
+    void DrawTheCamera()
+    {
+        auto head = _arena.Head(0);
+        auto left = head.first - screenWidth / 2;
+        auto top = head.second - screenHeight / 2;
+
+        for (int y = 0; y < screenHeight; y++)
+        {
+            for (int x = 0; x < screenWidth; x++)
+            {
+                Draw(x, y, ColourOf(std::make_pair(left + x, top + y)));
+            }
+        }
+
+        auto alive = _arena.IsAlive(0);
+
+        for (size_t n = 0; n < _arena.Length(0); n++)
+        {
+            auto c = _arena.Body(0, n);
+            Draw(c.first - left, c.second - top, alive ? n == 0 ? olc::VERY_DARK_GREEN : olc::GREEN : olc::RED);
+        }
+    }
+
+    olc::Pixel ColourOf(const Coordinates& c) const
+    {
+        if (!_arena.Board().InBounds(c.first, c.second))
+        {
+            return olc::VERY_DARK_GREY;
+        }
+
+        if (_arena.IsBorder(c.first, c.second))
+        {
+            return olc::GREY;
+        }
+
+        if (_arena.IsBody(c))
+        {
+            return olc::YELLOW;
+        }
+
+        if (_arena.IsBad(c))
+        {
+            return olc::MAGENTA;
+        }
+
+        return _arena.IsGood(c) ? olc::CYAN : olc::BLACK;
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+
+// Reads a count from the command line. Only plain decimal numbers pass, and zero
+// only where it means something, so a tool handed a typo says so rather than
+// quietly doing nothing
+inline bool ParseNumber(const char* text, uint64_t& value, bool zero)
+{
+    if (*text < '0' || *text > '9')
+    {
+        return false;
+    }
+
+    char* end;
+    errno = 0;
+    value = std::strtoull(text, &end, 10);
+    return *end == 0 && errno == 0 && (zero || value > 0);
+}
@@ -0,0 +1,312 @@
+#pragma once
+
+#include "Game.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+// Steers a Game towards the nearest good obstacle. The distance to it is kept for
+// every cell and repaired from the cells the last tick changed instead of being
+// searched again. Repairs stop when the per-tick budget runs out, and the next
+// tick carries on from there. A move into a region too small to hold the snake
+// is taken only when every move leads into one.
+template <int width, int height>
+class Autopilot
+{
+public:
+    explicit Autopilot(std::chrono::microseconds budget = std::chrono::microseconds(250)) :
+        _walls(Game<width, height>().Walls()),
+        _budget(budget),
+        _tickCount(0)
+    {
+        _queue.Reserve(Cells * 4);
+    }
+
+    // Rebuilds everything from the game, for when we did not see every tick
+    void Attach(const Game<width, height>& game)
+    {
+        _walls = game.Walls();
+        _body.fill(0);
+        _good.fill(0);
+        _bad.fill(0);
+        _distance.fill(Unreachable);
+        _obstacles.clear();
+        ClearQueue();
+
+        for (size_t n = 0; n < game.Length(); n++)
+        {
+            Apply(Game<width, height>::EventType::BodyAppended, game.Body(n));
+        }
+
+        for (size_t n = 0; n < game.ObstacleCount(); n++)
+        {
+            auto c = game.Obstacle(n);
+
+            if (game.IsGood(c))
+            {
+                Apply(Game<width, height>::EventType::GoodSpawned, c);
+            }
+
+            if (game.IsBad(c))
+            {
+                Apply(Game<width, height>::EventType::BadSpawned, c);
+            }
+        }
+
+        _tickCount = game.TickCount();
+    }
+
+    void Update(const Game<width, height>& game)
+    {
+        if (game.TickCount() != _tickCount + 1)
+        {
+            Attach(game);
+        }
+        else
+        {
+            for (auto& e : game.Events())
+            {
+                Apply(e.type, e.cell);
+            }
+
+            _tickCount = game.TickCount();
+        }
+
+        Repair();
+    }
+
+    Direction Steer(const Game<width, height>& game) const
+    {
+        auto head = game.Head();
+        auto best = game.GetDirection();
+        auto bestDistance = Unreachable;
+        size_t bestArea = 0;
+        bool found = false;
+
+        for (auto direction : {game.GetDirection(), Direction::North, Direction::East, Direction::South, Direction::West})
+        {
+            auto c = Neighbour(head, direction);
+
+            if (!InBounds(c) || IsBlocked(Index(c)))
+            {
+                continue;
+            }
+
+            auto area = std::min(game.Reachable(c).Count(), game.Length());
+            auto distance = _distance[Index(c)];
+
+            if (!found || area > bestArea || (area == bestArea && distance < bestDistance))
+            {
+                best = direction;
+                bestDistance = distance;
+                bestArea = area;
+                found = true;
+            }
+        }
+
+        return best;
+    }
+
+    constexpr uint32_t Distance(const Coordinates& c) const
+    {
+        return InBounds(c) ? _distance[Index(c)] : Unreachable;
+    }
+
+private:
+    static constexpr uint32_t Unreachable = UINT32_MAX;
+    static constexpr int Cells = width * height;
+
+    using Entry = std::pair<uint32_t, uint32_t>;
+    // Emptied without giving up its storage, which is reserved once
+    struct Queue :
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>
+    {
+        void Clear()
+        {
+            c.clear();
+        }
+
+        void Reserve(size_t n)
+        {
+            c.reserve(n);
+        }
+    };
+
+    std::array<uint16_t, Cells> _body;
+    std::array<uint8_t, Cells> _good;
+    std::array<uint8_t, Cells> _bad;
+    Bitboard<width, height> _walls;
+    std::array<uint32_t, Cells> _distance;
+    std::vector<uint32_t> _obstacles;
+    Queue _queue;
+    std::chrono::microseconds _budget;
+    size_t _tickCount;
+
+    static constexpr bool InBounds(const Coordinates& c)
+    {
+        return c.first >= 0 && c.first < width && c.second >= 0 && c.second < height;
+    }
+
+    static constexpr uint32_t Index(const Coordinates& c)
+    {
+        return uint32_t(c.second * width + c.first);
+    }
+
+    static constexpr Coordinates Neighbour(const Coordinates& c, Direction direction)
+    {
+        switch (direction)
+        {
+            case Direction::North: return {c.first, c.second - 1};
+            case Direction::East:  return {c.first + 1, c.second};
+            case Direction::South: return {c.first, c.second + 1};
+            case Direction::West:  return {c.first - 1, c.second};
+        }
+
+        return c;
+    }
+
+    constexpr bool IsBlocked(uint32_t i) const
+    {
+        return _walls.Test(std::make_pair(int(i % width), int(i / width))) || _body[i] || _bad[i];
+    }
+
+    void ClearQueue()
+    {
+        _queue.Clear();
+    }
+
+    void Apply(typename Game<width, height>::EventType type, const Coordinates& c)
+    {
+        using EventType = typename Game<width, height>::EventType;
+
+        if (type == EventType::ObstaclesCleared)
+        {
+            // Every distance was measured to the obstacles now gone, so start over
+            for (auto i : _obstacles)
+            {
+                _good[i] = 0;
+                _bad[i] = 0;
+            }
+
+            _obstacles.clear();
+            _distance.fill(Unreachable);
+            ClearQueue();
+            return;
+        }
+
+        if (!InBounds(c))
+        {
+            return;
+        }
+
+        auto i = Index(c);
+
+        switch (type)
+        {
+            case EventType::HeadAdded:
+            case EventType::BodyAppended: _body[i]++; break;
+            case EventType::TailRemoved:  _body[i]--; break;
+            case EventType::GoodSpawned:  _good[i]++; _obstacles.push_back(i); break;
+            case EventType::BadSpawned:   _bad[i]++; _obstacles.push_back(i); break;
+            default: break;
+        }
+
+        Touch(i);
+    }
+
+    // The distance a cell should have given its neighbours' current distances
+    uint32_t Expected(uint32_t i) const
+    {
+        if (IsBlocked(i))
+        {
+            return Unreachable;
+        }
+
+        if (_good[i])
+        {
+            return 0;
+        }
+
+        auto x = int(i % width);
+        auto y = int(i / width);
+        auto best = Unreachable;
+
+        if (x > 0)          best = std::min(best, _distance[i - 1]);
+        if (x < width - 1)  best = std::min(best, _distance[i + 1]);
+        if (y > 0)          best = std::min(best, _distance[i - width]);
+        if (y < height - 1) best = std::min(best, _distance[i + width]);
+
+        return best == Unreachable ? Unreachable : best + 1;
+    }
+
+    void Touch(uint32_t i)
+    {
+        auto expected = Expected(i);
+
+        if (expected != _distance[i])
+        {
+            _queue.push({std::min(expected, _distance[i]), i});
+        }
+    }
+
+    void TouchNeighbours(uint32_t i)
+    {
+        auto x = int(i % width);
+        auto y = int(i / width);
+
+        if (x > 0)          Touch(i - 1);
+        if (x < width - 1)  Touch(i + 1);
+        if (y > 0)          Touch(i - width);
+        if (y < height - 1) Touch(i + width);
+    }
+
+    // Settles cells nearest first: a cell that got closer takes its new distance, one
+    // that got further is raised to unreachable and queued again to be lowered
+    void Repair()
+    {
+        auto deadline = std::chrono::steady_clock::now() + _budget;
+        size_t n = 0;
+
+        while (!_queue.empty())
+        {
+            if ((++n & 63) == 0 && std::chrono::steady_clock::now() >= deadline)
+            {
+                break;
+            }
+
+            auto [key, i] = _queue.top();
+            _queue.pop();
+
+            auto expected = Expected(i);
+            auto current = std::min(expected, _distance[i]);
+
+            if (expected == _distance[i] || current < key)
+            {
+                continue;
+            }
+
+            if (current > key)
+            {
+                _queue.push({current, i});
+                continue;
+            }
+
+            if (expected < _distance[i])
+            {
+                _distance[i] = expected;
+            }
+            else
+            {
+                _distance[i] = Unreachable;
+                Touch(i);
+            }
+
+            TouchNeighbours(i);
+        }
+    }
+};
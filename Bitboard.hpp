@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// One bit per cell, sized at compile time. Rows are padded with at least one spare
+// bit, and the board has an empty row above and below it, so a flood fill never
+// needs bounds checks and every word operation moves 64 cells at a time.
+template <int width, int height>
+class Bitboard
+{
+public:
+    static constexpr int Words = width / 64 + 1;
+    static constexpr int Size = Words * (height + 2);
+
+    constexpr Bitboard() :
+        _words{}
+    {}
+
+    constexpr bool Test(const std::pair<int, int>& c) const
+    {
+        return (_words[Word(c)] >> Bit(c)) & 1;
+    }
+
+    constexpr void Set(const std::pair<int, int>& c)
+    {
+        _words[Word(c)] |= uint64_t(1) << Bit(c);
+    }
+
+    constexpr void Reset(const std::pair<int, int>& c)
+    {
+        _words[Word(c)] &= ~(uint64_t(1) << Bit(c));
+    }
+
+    constexpr void Assign(const std::pair<int, int>& c, bool set)
+    {
+        set ? Set(c) : Reset(c);
+    }
+
+    // Takes the words of a board laid out as this one, such as a level's walls
+    void Load(const uint64_t* words)
+    {
+        std::copy(words, words + Size, _words.begin());
+    }
+
+    size_t Count() const
+    {
+        size_t count = 0;
+
+        for (auto w : _words)
+        {
+            count += std::bitset<64>(w).count();
+        }
+
+        return count;
+    }
+
+    Bitboard operator&(const Bitboard& other) const
+    {
+        Bitboard result;
+
+        for (int n = 0; n < Size; n++)
+        {
+            result._words[n] = _words[n] & other._words[n];
+        }
+
+        return result;
+    }
+
+    // Everything reachable from seed by stepping through cells set in open
+    static Bitboard Fill(const Bitboard& seed, const Bitboard& open)
+    {
+        Bitboard reach = seed;
+        bool down = true;
+
+        while (reach.Sweep(open, down))
+        {
+            down = !down;
+        }
+
+        return reach;
+    }
+
+private:
+    alignas(32) std::array<uint64_t, Size> _words;
+
+    static constexpr int Word(const std::pair<int, int>& c)
+    {
+        return (c.second + 1) * Words + c.first / 64;
+    }
+
+    static constexpr int Bit(const std::pair<int, int>& c)
+    {
+        return c.first % 64;
+    }
+
+    // Fills x along runs of open bits within the word, in both directions, in six
+    // doubling steps. Bits already in x stay set even where they are not open
+    static constexpr uint64_t Spread(uint64_t x, uint64_t open)
+    {
+        uint64_t east = x, west = x, e = open, w = open;
+
+        for (int shift = 1; shift < 64; shift *= 2)
+        {
+            east |= e & (east << shift);
+            west |= w & (west >> shift);
+            e &= e << shift;
+            w &= w >> shift;
+        }
+
+        return east | west;
+    }
+
+#if defined(__AVX2__)
+    static __m256i Spread(__m256i x, __m256i open)
+    {
+        auto east = x, west = x, e = open, w = open;
+
+        for (int shift = 1; shift < 64; shift *= 2)
+        {
+            auto count = _mm_cvtsi32_si128(shift);
+            east = _mm256_or_si256(east, _mm256_and_si256(e, _mm256_sll_epi64(east, count)));
+            west = _mm256_or_si256(west, _mm256_and_si256(w, _mm256_srl_epi64(west, count)));
+            e = _mm256_and_si256(e, _mm256_sll_epi64(e, count));
+            w = _mm256_and_si256(w, _mm256_srl_epi64(w, count));
+        }
+
+        return _mm256_or_si256(east, west);
+    }
+#endif
+
+    // Takes one sweep over the rows, downwards or upwards, and returns true if any cell
+    // was added. Each row first takes in the rows above and below it and spreads along
+    // its open runs. It then carries runs across word boundaries. Rows are updated in
+    // place, so a sweep floods as far as the region goes in its direction, and sweeps
+    // are only repeated where the path turns back.
+    bool Sweep(const Bitboard& open, bool down)
+    {
+        uint64_t changed = 0;
+
+        for (int r = 0; r < height; r++)
+        {
+            auto row = (down ? r : height - 1 - r) + 1;
+            auto* w = _words.data() + row * Words;
+            auto* o = open._words.data() + row * Words;
+            auto* above = w - Words;
+            auto* below = w + Words;
+            int n = 0;
+
+#if defined(__AVX2__)
+            __m256i changes = _mm256_setzero_si256();
+
+            for (; n + 4 <= Words; n += 4)
+            {
+                auto cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + n));
+                auto mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(o + n));
+                auto up = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(above + n));
+                auto dn = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(below + n));
+
+                auto grown = _mm256_or_si256(cur, _mm256_and_si256(_mm256_or_si256(up, dn), mask));
+                grown = Spread(grown, mask);
+
+                changes = _mm256_or_si256(changes, _mm256_xor_si256(grown, cur));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(w + n), grown);
+            }
+
+            changed |= !_mm256_testz_si256(changes, changes);
+#endif
+
+            for (; n < Words; n++)
+            {
+                auto grown = Spread(w[n] | ((above[n] | below[n]) & o[n]), o[n]);
+                changed |= grown ^ w[n];
+                w[n] = grown;
+            }
+
+            for (n = 1; n < Words; n++)
+            {
+                auto carry = (w[n - 1] >> 63) & o[n] & ~w[n];
+
+                if (carry)
+                {
+                    auto grown = Spread(w[n] | carry, o[n]);
+                    changed |= grown ^ w[n];
+                    w[n] = grown;
+                }
+            }
+
+            for (n = Words - 2; n >= 0; n--)
+            {
+                auto carry = (w[n + 1] << 63) & o[n] & ~w[n];
+
+                if (carry)
+                {
+                    auto grown = Spread(w[n] | carry, o[n]);
+                    changed |= grown ^ w[n];
+                    w[n] = grown;
+                }
+            }
+        }
+
+        return changed != 0;
+    }
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One byte per cell for boards far too large to allocate densely. Cells live in
+// 64x64 chunks that are allocated the first time a cell in them becomes non-zero
+// and freed once every cell in them is zero again. Chunks are found through a
+// directory of bands, each one row of chunks across the board, which are also
+// allocated on demand, so memory follows the occupied area rather than the board
+// area. Untouched cells read as zero.
+//
+// Writers working on different bands share nothing but the chunk count, which is
+// atomic, so each band can be written by its own thread.
+class ChunkedBoard
+{
+public:
+    static constexpr int ChunkBits = 6;
+    static constexpr int ChunkSize = 1 << ChunkBits;
+
+    ChunkedBoard(int64_t width, int64_t height) :
+        _width(width),
+        _height(height),
+        _bandWidth((width + ChunkSize - 1) / ChunkSize),
+        _bands(size_t((height + ChunkSize - 1) / ChunkSize)),
+        _chunks(0)
+    {}
+
+    int64_t Width() const
+    {
+        return _width;
+    }
+
+    int64_t Height() const
+    {
+        return _height;
+    }
+
+    bool InBounds(int64_t x, int64_t y) const
+    {
+        return x >= 0 && x < _width && y >= 0 && y < _height;
+    }
+
+    uint8_t Get(int64_t x, int64_t y) const
+    {
+        auto* chunk = Find(x, y);
+        return chunk ? chunk->cells[CellIndex(x, y)] : 0;
+    }
+
+    void Set(int64_t x, int64_t y, uint8_t value)
+    {
+        if (!InBounds(x, y))
+        {
+            return;
+        }
+
+        auto& band = _bands[size_t(y >> ChunkBits)];
+
+        if (!band)
+        {
+            if (!value)
+            {
+                return;
+            }
+
+            band = std::make_unique<Band>(size_t(_bandWidth));
+        }
+
+        auto& chunk = band->chunks[size_t(x >> ChunkBits)];
+
+        if (!chunk)
+        {
+            if (!value)
+            {
+                return;
+            }
+
+            chunk = std::make_unique<Chunk>();
+            band->used++;
+            _chunks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        auto& cell = chunk->cells[CellIndex(x, y)];
+        chunk->used += (value != 0) - (cell != 0);
+        cell = value;
+
+        if (chunk->used == 0)
+        {
+            chunk.reset();
+            _chunks.fetch_sub(1, std::memory_order_relaxed);
+
+            if (--band->used == 0)
+            {
+                band.reset();
+            }
+        }
+    }
+
+    // Chunks currently allocated
+    size_t Chunks() const
+    {
+        return _chunks.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Chunk
+    {
+        std::array<uint8_t, ChunkSize * ChunkSize> cells{};
+        uint32_t used = 0;
+    };
+
+    struct Band
+    {
+        explicit Band(size_t width) :
+            chunks(width)
+        {}
+
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        uint32_t used = 0;
+    };
+
+    int64_t _width;
+    int64_t _height;
+    int64_t _bandWidth;
+    std::vector<std::unique_ptr<Band>> _bands;
+    std::atomic<size_t> _chunks;
+
+    static size_t CellIndex(int64_t x, int64_t y)
+    {
+        return size_t((y & (ChunkSize - 1)) * ChunkSize + (x & (ChunkSize - 1)));
+    }
+
+    const Chunk* Find(int64_t x, int64_t y) const
+    {
+        if (!InBounds(x, y))
+        {
+            return nullptr;
+        }
+
+        auto& band = _bands[size_t(y >> ChunkBits)];
+        return band ? band->chunks[size_t(x >> ChunkBits)].get() : nullptr;
+    }
+};
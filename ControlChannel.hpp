@@ -0,0 +1,229 @@
+#pragma once
+
+#include "Game.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// A game shared with a controller in another process through POSIX shared memory.
+// The game publishes a copy of itself after every tick under a seqlock, so readers
+// never block the game and simply retry a copy that raced a publish. Directions go
+// the other way through a single-producer ring. Neither side makes a syscall in
+// the steady state. A controller that would rather sleep than poll can wait for the
+// next publish on a futex, which the game only wakes when someone is waiting.
+template <int width, int height>
+class ControlChannel
+{
+    static_assert(std::is_trivially_copyable<Game<width, height>>::value, "Snapshots are copied between processes");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "Atomics must work across processes");
+
+public:
+    enum class Mode
+    {
+        Create,
+        Open
+    };
+
+    ControlChannel(const std::string& name, Mode mode) :
+        _name(name),
+        _mode(mode)
+    {
+        auto fd = shm_open(name.c_str(), mode == Mode::Create ? O_CREAT | O_RDWR | O_TRUNC : O_RDWR, 0600);
+        Check(fd, "shm_open");
+
+        if (mode == Mode::Create && ftruncate(fd, sizeof(Shared)) < 0)
+        {
+            auto error = errno;
+            close(fd);
+            shm_unlink(name.c_str());
+            throw std::system_error(error, std::generic_category(), "ftruncate");
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) < 0 || size_t(info.st_size) != sizeof(Shared))
+        {
+            close(fd);
+            throw std::runtime_error("Control channel " + name + " does not match this game");
+        }
+
+        auto memory = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        auto error = errno;
+        close(fd);
+
+        if (memory == MAP_FAILED)
+        {
+            throw std::system_error(error, std::generic_category(), "mmap");
+        }
+
+        _shared = mode == Mode::Create ? new (memory) Shared() : static_cast<Shared*>(memory);
+    }
+
+    ~ControlChannel()
+    {
+        munmap(_shared, sizeof(Shared));
+
+        if (_mode == Mode::Create)
+        {
+            shm_unlink(_name.c_str());
+        }
+    }
+
+    ControlChannel(const ControlChannel&) = delete;
+    ControlChannel& operator=(const ControlChannel&) = delete;
+
+    // Game side: makes this position the one controllers read
+    void Publish(const Game<width, height>& game, bool alive = true)
+    {
+        auto sequence = _shared->sequence.load(std::memory_order_relaxed);
+        _shared->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::memcpy(static_cast<void*>(&_shared->game), &game, sizeof(game));
+        _shared->alive = alive;
+
+        _shared->sequence.store(sequence + 2, std::memory_order_seq_cst);
+
+        if (_shared->waiters.load(std::memory_order_seq_cst) > 0)
+        {
+            Futex(FUTEX_WAKE, INT_MAX, nullptr);
+        }
+    }
+
+    // Game side: takes the oldest direction a controller sent, if there is one
+    bool Receive(Direction& direction)
+    {
+        auto head = _shared->head.load(std::memory_order_relaxed);
+
+        if (head == _shared->tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        direction = Direction(_shared->actions[head % Actions]);
+        _shared->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Controller side: copies the latest position and returns its sequence number,
+    // which Wait() takes to sleep until the next one. A publish takes microseconds,
+    // so after a while of retrying the reader yields, and it throws once the game
+    // looks to have died part way through one
+    uint32_t Read(Game<width, height>& game, bool& alive) const
+    {
+        auto deadline = std::chrono::steady_clock::now() + ReadTimeout;
+
+        for (uint32_t attempt = 0;; attempt++)
+        {
+            if (attempt >= SpinAttempts)
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    throw std::runtime_error("Control channel " + _name + " was left in the middle of a publish");
+                }
+
+                std::this_thread::yield();
+            }
+
+            auto before = _shared->sequence.load(std::memory_order_acquire);
+
+            if (before & 1)
+            {
+                continue;
+            }
+
+            std::memcpy(static_cast<void*>(&game), &_shared->game, sizeof(game));
+            alive = _shared->alive;
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (_shared->sequence.load(std::memory_order_relaxed) == before)
+            {
+                return before;
+            }
+        }
+    }
+
+    // Controller side: returns false if the game has not caught up with the ring
+    bool Send(Direction direction)
+    {
+        auto tail = _shared->tail.load(std::memory_order_relaxed);
+
+        if (tail - _shared->head.load(std::memory_order_acquire) == Actions)
+        {
+            return false;
+        }
+
+        _shared->actions[tail % Actions] = uint8_t(direction);
+        _shared->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Controller side: sleeps until something newer than seen is published, or the
+    // timeout passes. Returns true if there is something newer
+    bool Wait(uint32_t seen, std::chrono::milliseconds timeout)
+    {
+        timespec limit{time_t(timeout.count() / 1000), long(timeout.count() % 1000 * 1000000)};
+
+        _shared->waiters.fetch_add(1, std::memory_order_seq_cst);
+
+        if (_shared->sequence.load(std::memory_order_seq_cst) == seen)
+        {
+            Futex(FUTEX_WAIT, seen, &limit);
+        }
+
+        _shared->waiters.fetch_sub(1, std::memory_order_seq_cst);
+        return _shared->sequence.load(std::memory_order_acquire) != seen;
+    }
+
+private:
+    static constexpr uint32_t Actions = 256;
+    static constexpr uint32_t SpinAttempts = 1024;
+    static constexpr std::chrono::milliseconds ReadTimeout{1000};
+
+    // The game's copy is read while it may be written; the sequence tells readers
+    // when to throw a copy away
+    struct Shared
+    {
+        alignas(64) std::atomic<uint32_t> sequence{0};
+        std::atomic<uint32_t> waiters{0};
+        bool alive = false;
+        Game<width, height> game;
+
+        alignas(64) std::atomic<uint32_t> head{0};
+        alignas(64) std::atomic<uint32_t> tail{0};
+        uint8_t actions[Actions] = {};
+    };
+
+    std::string _name;
+    Mode _mode;
+    Shared* _shared;
+
+    long Futex(int operation, uint32_t value, const timespec* timeout)
+    {
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "The futex word is the sequence itself");
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_shared->sequence), operation, value, timeout, nullptr, 0);
+    }
+
+    static void Check(int result, const char* what)
+    {
+        if (result < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+    }
+};
@@ -0,0 +1,791 @@
+#pragma once
+
+#include "Game.hpp"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Recorded play for training bots offline, one row per tick: what the bot saw,
+// the move it made and what that earned. Rows are written in shards of columns,
+// so a trainer maps a shard and reads one column of many rows without touching
+// the rest.
+//
+// The board is four planes of one bit per cell, walls, body, good and bad. They
+// are the bulk of a row and change by a few cells a tick, so each plane is kept
+// in blocks of rows, each row XORed with the one before it (the first in a block
+// with nothing) and the zero bytes that leaves run-length coded. Reading a row
+// decodes at most one block.
+//
+// Numbers are little-endian, every section starts on a 64-byte boundary and a cell
+// is its u16 index y * width + x. A plane is width * height bits in the order of
+// the cells, the first in the low bit of the first byte. Version 1:
+//   header     64 bytes, as Header
+//   columns    u32 game, u32 tick, u16 head, u8 direction, u8 action, i32 reward,
+//              u8 done, each a section of one value per row
+//   index      u32 offsets for each plane, of each block and of the plane's end
+//   planes     the blocks of each plane in turn. A row is a series of tokens: a
+//              byte t below 0x80 is followed by t + 1 bytes as they are, and one
+//              from 0x80 stands for t - 0x7F zero bytes
+namespace Dataset
+{
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Shards are mapped as they are stored");
+
+    constexpr uint16_t Version = 1;
+
+    enum class Plane
+    {
+        Walls,
+        Body,
+        Good,
+        Bad
+    };
+
+    constexpr size_t Planes = 4;
+
+    struct Row
+    {
+        uint32_t game;
+        uint32_t tick;
+        uint16_t head;
+        // Where the snake was heading, and where it was sent
+        Direction direction;
+        Direction action;
+        // Score earned by the move
+        int32_t reward;
+        // The move ended the game
+        bool done;
+    };
+
+    namespace Detail
+    {
+        constexpr const char* Magic = "SNKD";
+
+        struct Header
+        {
+            char magic[4];
+            uint16_t version;
+            uint16_t width;
+            uint16_t height;
+            uint16_t planes;
+            uint32_t rows;
+            uint32_t blockRows;
+            uint32_t planeBytes;
+            uint32_t size;
+            uint32_t game;
+            uint32_t tick;
+            uint32_t head;
+            uint32_t direction;
+            uint32_t action;
+            uint32_t reward;
+            uint32_t done;
+            uint32_t index;
+            uint8_t reserved[4];
+        };
+
+        static_assert(sizeof(Header) == 64, "The header is one 64-byte section");
+
+        inline void Encode(const uint8_t* bytes, size_t size, std::vector<uint8_t>& out)
+        {
+            for (size_t n = 0; n < size;)
+            {
+                size_t run = n;
+                while (run < size && run - n < 0x80 && bytes[run] == 0)
+                {
+                    run++;
+                }
+
+                if (run > n)
+                {
+                    out.push_back(uint8_t(0x7F + run - n));
+                    n = run;
+                    continue;
+                }
+
+                // Literals stop at a pair of zeros, which a run costs no more than
+                size_t end = n;
+                while (end < size && end - n < 0x80 && !(bytes[end] == 0 && end + 1 < size && bytes[end + 1] == 0))
+                {
+                    end++;
+                }
+
+                out.push_back(uint8_t(end - n - 1));
+                out.insert(out.end(), bytes + n, bytes + end);
+                n = end;
+            }
+        }
+
+        // XORs one row decoded from in into bytes and returns where the next starts
+        inline const uint8_t* Decode(const uint8_t* in, const uint8_t* end, uint8_t* bytes, size_t size)
+        {
+            for (size_t n = 0; n < size;)
+            {
+                if (in == end)
+                {
+                    throw std::runtime_error("Plane ends inside a row");
+                }
+
+                auto token = *in++;
+
+                if (token >= 0x80)
+                {
+                    n += size_t(token) - 0x7F;
+                    continue;
+                }
+
+                size_t count = size_t(token) + 1;
+                if (count > size - n || count > size_t(end - in))
+                {
+                    throw std::runtime_error("Plane runs past its row");
+                }
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    bytes[n + i] ^= in[i];
+                }
+
+                in += count;
+                n += count;
+            }
+
+            return in;
+        }
+    }
+
+    // Takes rows from the game's thread and writes shards on a thread of its own.
+    // The two share a fixed ring of rows, so the game waits only if the writer
+    // falls a whole ring behind, and the writer holds no more than one shard.
+    // Shards are named prefix-000000.snkd on, each written aside and renamed
+    template <int width, int height>
+    class Writer
+    {
+        static_assert(width * height <= UINT16_MAX, "Cells are stored as u16 indices");
+
+    public:
+        static constexpr size_t PlaneBytes = (size_t(width) * height + 7) / 8;
+
+        explicit Writer(const std::string& prefix, uint32_t rowsPerShard = 65536, size_t ringRows = 1024, uint32_t blockRows = 64) :
+            _prefix(prefix),
+            _rowsPerShard(rowsPerShard),
+            _blockRows(blockRows),
+            _ring(std::max<size_t>(ringRows, 1)),
+            _taken(0),
+            _queued(0),
+            _stop(false),
+            _shards(0),
+            _lastGame(UINT32_MAX),
+            _rows(0)
+        {
+            // The worst a row can code to is a token for every 128 bytes on top of them
+            auto worst = uint64_t(rowsPerShard) * Planes * (PlaneBytes + PlaneBytes / 128 + 1);
+
+            if (rowsPerShard == 0 || blockRows == 0 || worst + (uint64_t(rowsPerShard) + 64) * 32 > UINT32_MAX)
+            {
+                throw std::invalid_argument("A shard holds at least one row and at most 4 GiB");
+            }
+
+            _thread = std::thread([this]() { Write(); });
+        }
+
+        ~Writer()
+        {
+            try
+            {
+                Close();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        // Records the position a move is about to be chosen in
+        void Observe(const Game<width, height>& game, uint32_t id)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _space.wait(lock, [this]() { return _queued - _taken < _ring.size() || _error; });
+            Rethrow();
+            lock.unlock();
+
+            auto& slot = _ring[_queued % _ring.size()];
+            auto head = game.Head();
+            slot.row = Row{id, uint32_t(game.TickCount()), uint16_t(head.second * width + head.first), game.GetDirection(), game.GetDirection(), 0, false};
+
+            // Walls only change between games
+            if (id != _lastGame)
+            {
+                _walls.fill(0);
+                for (int y = 0; y < height; y++)
+                {
+                    for (int x = 0; x < width; x++)
+                    {
+                        if (game.IsWall(std::make_pair(x, y)))
+                        {
+                            Mark(_walls.data(), std::make_pair(x, y));
+                        }
+                    }
+                }
+
+                _lastGame = id;
+            }
+
+            std::copy(_walls.begin(), _walls.end(), slot.plane(Plane::Walls));
+            std::fill(slot.plane(Plane::Body), slot.planes.end(), 0);
+
+            for (size_t n = 0; n < game.Length(); n++)
+            {
+                Mark(slot.plane(Plane::Body), game.Body(n));
+            }
+
+            for (size_t n = 0; n < game.ObstacleCount(); n++)
+            {
+                auto c = game.Obstacle(n);
+                Mark(slot.plane(game.IsBad(c) ? Plane::Bad : Plane::Good), c);
+            }
+        }
+
+        // Completes the row Observe() began with the move made and what came of it
+        void Outcome(Direction action, int32_t reward, bool done)
+        {
+            auto& row = _ring[_queued % _ring.size()].row;
+            row.action = action;
+            row.reward = reward;
+            row.done = done;
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _queued++;
+            }
+
+            _ready.notify_one();
+        }
+
+        // Writes the rows still queued, and the last shard however short, and
+        // throws if any shard could not be written
+        void Close()
+        {
+            if (_thread.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _stop = true;
+                }
+
+                _ready.notify_one();
+                _thread.join();
+            }
+
+            Rethrow();
+        }
+
+        size_t Shards() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _shards;
+        }
+
+    private:
+        struct Slot
+        {
+            Row row;
+            std::array<uint8_t, Planes * PlaneBytes> planes;
+
+            uint8_t* plane(Plane p)
+            {
+                return planes.data() + size_t(p) * PlaneBytes;
+            }
+        };
+
+        std::string _prefix;
+        uint32_t _rowsPerShard;
+        uint32_t _blockRows;
+        std::vector<Slot> _ring;
+        // Rows the writer has taken from the ring, and rows the game has put in
+        size_t _taken;
+        size_t _queued;
+        bool _stop;
+        std::exception_ptr _error;
+        size_t _shards;
+        mutable std::mutex _mutex;
+        std::condition_variable _ready;
+        std::condition_variable _space;
+        std::thread _thread;
+
+        // The game's side
+        uint32_t _lastGame;
+        std::array<uint8_t, PlaneBytes> _walls;
+
+        // The writer's side: the shard so far
+        uint32_t _rows;
+        std::vector<uint32_t> _games;
+        std::vector<uint32_t> _ticks;
+        std::vector<uint16_t> _heads;
+        std::vector<uint8_t> _directions;
+        std::vector<uint8_t> _actions;
+        std::vector<int32_t> _rewards;
+        std::vector<uint8_t> _done;
+        std::array<std::vector<uint8_t>, Planes> _data;
+        std::array<std::vector<uint32_t>, Planes> _blocks;
+        std::array<uint8_t, Planes * PlaneBytes> _previous;
+        std::array<uint8_t, PlaneBytes> _delta;
+
+        static void Mark(uint8_t* plane, const Coordinates& c)
+        {
+            auto n = size_t(c.second * width + c.first);
+            plane[n / 8] |= uint8_t(1u << (n % 8));
+        }
+
+        void Rethrow()
+        {
+            if (_error)
+            {
+                std::rethrow_exception(_error);
+            }
+        }
+
+        void Write()
+        {
+            try
+            {
+                while (true)
+                {
+                    size_t head;
+                    size_t tail;
+                    bool stop;
+                    {
+                        std::unique_lock<std::mutex> lock(_mutex);
+                        _ready.wait(lock, [this]() { return _queued != _taken || _stop; });
+                        head = _taken;
+                        tail = _queued;
+                        stop = _stop;
+                    }
+
+                    for (auto n = head; n < tail; n++)
+                    {
+                        Append(_ring[n % _ring.size()]);
+
+                        if (_rows == _rowsPerShard)
+                        {
+                            Flush();
+                        }
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> lock(_mutex);
+                        _taken = tail;
+                    }
+
+                    _space.notify_one();
+
+                    if (stop && tail == head)
+                    {
+                        Flush();
+                        return;
+                    }
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _error = std::current_exception();
+                _space.notify_one();
+            }
+        }
+
+        void Append(const Slot& slot)
+        {
+            auto& row = slot.row;
+            _games.push_back(row.game);
+            _ticks.push_back(row.tick);
+            _heads.push_back(row.head);
+            _directions.push_back(uint8_t(row.direction));
+            _actions.push_back(uint8_t(row.action));
+            _rewards.push_back(row.reward);
+            _done.push_back(row.done);
+
+            if (_rows % _blockRows == 0)
+            {
+                _previous.fill(0);
+
+                for (size_t p = 0; p < Planes; p++)
+                {
+                    _blocks[p].push_back(uint32_t(_data[p].size()));
+                }
+            }
+
+            for (size_t p = 0; p < Planes; p++)
+            {
+                auto* plane = slot.planes.data() + p * PlaneBytes;
+                auto* previous = _previous.data() + p * PlaneBytes;
+
+                for (size_t n = 0; n < PlaneBytes; n++)
+                {
+                    _delta[n] = plane[n] ^ previous[n];
+                }
+
+                Detail::Encode(_delta.data(), PlaneBytes, _data[p]);
+                std::copy(plane, plane + PlaneBytes, previous);
+            }
+
+            _rows++;
+        }
+
+        template <typename T>
+        static uint32_t Section(std::vector<uint8_t>& out, const std::vector<T>& values)
+        {
+            out.resize((out.size() + 63) / 64 * 64);
+            auto offset = uint32_t(out.size());
+            auto* bytes = reinterpret_cast<const uint8_t*>(values.data());
+            out.insert(out.end(), bytes, bytes + values.size() * sizeof(T));
+            return offset;
+        }
+
+        void Flush()
+        {
+            if (_rows == 0)
+            {
+                return;
+            }
+
+            Detail::Header header{};
+            std::memcpy(header.magic, Detail::Magic, sizeof(header.magic));
+            header.version = Version;
+            header.width = uint16_t(width);
+            header.height = uint16_t(height);
+            header.planes = uint16_t(Planes);
+            header.rows = _rows;
+            header.blockRows = _blockRows;
+            header.planeBytes = uint32_t(PlaneBytes);
+
+            std::vector<uint8_t> out(sizeof(header));
+            header.game = Section(out, _games);
+            header.tick = Section(out, _ticks);
+            header.head = Section(out, _heads);
+            header.direction = Section(out, _directions);
+            header.action = Section(out, _actions);
+            header.reward = Section(out, _rewards);
+            header.done = Section(out, _done);
+
+            // The index points past itself, so its size comes first
+            auto blocks = _blocks[0].size();
+            std::vector<uint32_t> index(Planes * (blocks + 1));
+            header.index = Section(out, index);
+            out.resize((out.size() + 63) / 64 * 64);
+
+            for (size_t p = 0; p < Planes; p++)
+            {
+                auto start = uint32_t(out.size());
+
+                for (size_t b = 0; b < blocks; b++)
+                {
+                    index[p * (blocks + 1) + b] = start + _blocks[p][b];
+                }
+
+                index[p * (blocks + 1) + blocks] = start + uint32_t(_data[p].size());
+                out.insert(out.end(), _data[p].begin(), _data[p].end());
+            }
+
+            std::memcpy(out.data() + header.index, index.data(), index.size() * sizeof(uint32_t));
+            header.size = uint32_t(out.size());
+            std::memcpy(out.data(), &header, sizeof(header));
+
+            char number[16];
+            std::snprintf(number, sizeof(number), "-%06zu", _shards);
+            auto path = _prefix + number + ".snkd";
+            auto aside = path + ".new";
+            {
+                std::ofstream file(aside, std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<const char*>(out.data()), std::streamsize(out.size()));
+
+                if (!file.flush())
+                {
+                    throw std::runtime_error("Could not write " + aside);
+                }
+            }
+
+            if (std::rename(aside.c_str(), path.c_str()) != 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "rename " + aside);
+            }
+
+            _rows = 0;
+            _games.clear();
+            _ticks.clear();
+            _heads.clear();
+            _directions.clear();
+            _actions.clear();
+            _rewards.clear();
+            _done.clear();
+
+            for (size_t p = 0; p < Planes; p++)
+            {
+                _data[p].clear();
+                _blocks[p].clear();
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _shards++;
+        }
+    };
+
+    // One shard, mapped. The columns are read in place, and planes are decoded a
+    // block at a time into the caller's buffer
+    class Shard
+    {
+    public:
+        explicit Shard(const std::string& path)
+        {
+            auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+            if (fd < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "open " + path);
+            }
+
+            struct stat info;
+            if (fstat(fd, &info) < 0)
+            {
+                auto error = errno;
+                close(fd);
+                throw std::system_error(error, std::generic_category(), "fstat " + path);
+            }
+
+            _size = size_t(info.st_size);
+
+            if (_size < sizeof(Detail::Header))
+            {
+                close(fd);
+                throw std::runtime_error("Shard " + path + " is too short");
+            }
+
+            auto memory = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            auto error = errno;
+            close(fd);
+
+            if (memory == MAP_FAILED)
+            {
+                throw std::system_error(error, std::generic_category(), "mmap " + path);
+            }
+
+            _data = static_cast<const uint8_t*>(memory);
+
+            try
+            {
+                Validate();
+            }
+            catch (std::runtime_error& e)
+            {
+                munmap(const_cast<uint8_t*>(_data), _size);
+                throw std::runtime_error("Shard " + path + " " + e.what());
+            }
+        }
+
+        ~Shard()
+        {
+            munmap(const_cast<uint8_t*>(_data), _size);
+        }
+
+        Shard(const Shard&) = delete;
+        Shard& operator=(const Shard&) = delete;
+
+        int Width() const
+        {
+            return GetHeader().width;
+        }
+
+        int Height() const
+        {
+            return GetHeader().height;
+        }
+
+        size_t Rows() const
+        {
+            return GetHeader().rows;
+        }
+
+        size_t PlaneBytes() const
+        {
+            return GetHeader().planeBytes;
+        }
+
+        Row Get(size_t row) const
+        {
+            return Row{Games()[row], Ticks()[row], Heads()[row], Direction(Directions()[row] & 3),
+                       Direction(Actions()[row] & 3), Rewards()[row], Done()[row] != 0};
+        }
+
+        const uint32_t* Games() const
+        {
+            return Column<uint32_t>(GetHeader().game);
+        }
+
+        const uint32_t* Ticks() const
+        {
+            return Column<uint32_t>(GetHeader().tick);
+        }
+
+        const uint16_t* Heads() const
+        {
+            return Column<uint16_t>(GetHeader().head);
+        }
+
+        const uint8_t* Directions() const
+        {
+            return Column<uint8_t>(GetHeader().direction);
+        }
+
+        const uint8_t* Actions() const
+        {
+            return Column<uint8_t>(GetHeader().action);
+        }
+
+        const int32_t* Rewards() const
+        {
+            return Column<int32_t>(GetHeader().reward);
+        }
+
+        const uint8_t* Done() const
+        {
+            return Column<uint8_t>(GetHeader().done);
+        }
+
+        // Decodes one plane of count rows from first into out, PlaneBytes() a row
+        void Read(Plane plane, size_t first, size_t count, uint8_t* out) const
+        {
+            auto& header = GetHeader();
+            auto bytes = size_t(header.planeBytes);
+
+            if (first > header.rows || count > header.rows - first)
+            {
+                throw std::out_of_range("Rows are past the end of the shard");
+            }
+
+            std::vector<uint8_t> row(bytes);
+            auto* index = Index() + size_t(plane) * (Blocks() + 1);
+
+            for (auto n = first; n < first + count;)
+            {
+                auto block = n / header.blockRows;
+                auto* in = _data + index[block];
+                auto* end = _data + index[block + 1];
+                std::fill(row.begin(), row.end(), 0);
+
+                // Rows before first in its block are decoded only to be built on
+                auto last = std::min(first + count, (block + 1) * size_t(header.blockRows));
+                for (auto r = block * size_t(header.blockRows); r < last; r++)
+                {
+                    in = Detail::Decode(in, end, row.data(), bytes);
+
+                    if (r >= n)
+                    {
+                        std::copy(row.begin(), row.end(), out + (r - first) * bytes);
+                    }
+                }
+
+                n = last;
+            }
+        }
+
+    private:
+        const uint8_t* _data;
+        size_t _size;
+
+        const Detail::Header& GetHeader() const
+        {
+            return *reinterpret_cast<const Detail::Header*>(_data);
+        }
+
+        template <typename T>
+        const T* Column(uint32_t offset) const
+        {
+            return reinterpret_cast<const T*>(_data + offset);
+        }
+
+        const uint32_t* Index() const
+        {
+            return Column<uint32_t>(GetHeader().index);
+        }
+
+        size_t Blocks() const
+        {
+            return (GetHeader().rows + GetHeader().blockRows - 1) / GetHeader().blockRows;
+        }
+
+        // Every section has to lie inside the file and every head inside the board,
+        // so a damaged shard is refused here rather than read past. Plane rows are
+        // checked as they are decoded
+        void Validate() const
+        {
+            auto& header = GetHeader();
+
+            if (std::memcmp(header.magic, Detail::Magic, sizeof(header.magic)) != 0)
+            {
+                throw std::runtime_error("is not a dataset shard");
+            }
+
+            if (header.version != Version)
+            {
+                throw std::runtime_error("is version " + std::to_string(header.version));
+            }
+
+            auto cells = size_t(header.width) * header.height;
+            if (header.size != _size || header.planes != Planes || header.blockRows == 0 || header.planeBytes != (cells + 7) / 8)
+            {
+                throw std::runtime_error("has a damaged header");
+            }
+
+            auto rows = size_t(header.rows);
+            auto section = [&](uint32_t offset, size_t bytes)
+            {
+                if (offset % 64 != 0 || offset < sizeof(Detail::Header) || offset > _size || bytes > _size - offset)
+                {
+                    throw std::runtime_error("has a section outside the file");
+                }
+            };
+
+            section(header.game, rows * 4);
+            section(header.tick, rows * 4);
+            section(header.head, rows * 2);
+            section(header.direction, rows);
+            section(header.action, rows);
+            section(header.reward, rows * 4);
+            section(header.done, rows);
+            section(header.index, Planes * (Blocks() + 1) * 4);
+
+            auto* index = Index();
+            for (size_t n = 0; n < Planes * (Blocks() + 1); n++)
+            {
+                if (index[n] > _size || (n % (Blocks() + 1) != 0 && index[n] < index[n - 1]))
+                {
+                    throw std::runtime_error("has a block outside the file");
+                }
+            }
+
+            for (size_t n = 0; n < rows; n++)
+            {
+                if (Heads()[n] >= cells)
+                {
+                    throw std::runtime_error("has a head off the board");
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,439 @@
+#pragma once
+
+#include "Game.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+// A compact stream of a game for spectators and clients. Most frames are deltas
+// that carry the events of one tick, so they cost the same however long the snake
+// is. Every so often a keyframe carries the whole state instead, so a reader can
+// join at any keyframe and a stream recovers from one it could not follow.
+//
+// Every frame starts with a tag byte, the format version in the high nibble and
+// the kind of frame in the low one, so a decoder can refuse a stream it does not
+// understand. Numbers are little-endian and a cell is its u16 index y * width + x.
+// Version 1:
+//   keyframe  0x11  u32 tick, u8 alive, u32 score, u16 length, length cells head
+//                   first, u16 good count, good cells, u16 bad count, bad cells
+//   delta     0x12  u32 tick, u8 alive, u8 count, count events
+// An event is a u8 kind, one of the codes of Event, and a cell. Obstacles are
+// cleared when the snake eats, and the cell of that event is the head.
+//
+// A frame that does not make sense, an unknown event or a cell off the board, is
+// refused whole: the decoder throws and keeps the state it had before the frame.
+namespace DeltaStream
+{
+    constexpr uint8_t Version = 1;
+    constexpr uint8_t Keyframe = Version << 4 | 1;
+    constexpr uint8_t Delta = Version << 4 | 2;
+
+    // The kinds of event on the wire. These are part of the format, so they are
+    // numbered here rather than taken from Game's order
+    enum class Event : uint8_t
+    {
+        HeadAdded = 0,
+        TailRemoved = 1,
+        BodyAppended = 2,
+        GoodSpawned = 3,
+        BadSpawned = 4,
+        ObstaclesCleared = 5
+    };
+
+    template <int width, int height>
+    class Encoder
+    {
+    public:
+        explicit Encoder(uint32_t keyframeInterval = 128) :
+            _keyframeInterval(keyframeInterval),
+            _sinceKeyframe(keyframeInterval)
+        {}
+
+        // Makes the next frame a keyframe, for a reader that has just joined
+        void RequestKeyframe()
+        {
+            _sinceKeyframe = _keyframeInterval;
+        }
+
+        // Appends the frame for the game's last tick
+        void Encode(const Game<width, height>& game, bool alive, std::vector<uint8_t>& out)
+        {
+            if (_sinceKeyframe >= _keyframeInterval)
+            {
+                EncodeKeyframe(game, alive, out);
+                _sinceKeyframe = 1;
+                return;
+            }
+
+            out.push_back(Delta);
+            Put32(out, uint32_t(game.TickCount()));
+            out.push_back(alive);
+            out.push_back(uint8_t(game.Events().size()));
+
+            for (auto& event : game.Events())
+            {
+                out.push_back(uint8_t(Code(event.type)));
+                Put16(out, Index(event.cell));
+            }
+
+            _sinceKeyframe++;
+        }
+
+    private:
+        uint32_t _keyframeInterval;
+        uint32_t _sinceKeyframe;
+
+        static void EncodeKeyframe(const Game<width, height>& game, bool alive, std::vector<uint8_t>& out)
+        {
+            out.push_back(Keyframe);
+            Put32(out, uint32_t(game.TickCount()));
+            out.push_back(alive);
+            Put32(out, uint32_t(game.Score()));
+            Put16(out, uint16_t(game.Length()));
+
+            for (size_t n = 0; n < game.Length(); n++)
+            {
+                Put16(out, Index(game.Body(n)));
+            }
+
+            for (auto bad : {false, true})
+            {
+                auto count = out.size();
+                Put16(out, 0);
+                uint16_t written = 0;
+
+                for (size_t n = 0; n < game.ObstacleCount(); n++)
+                {
+                    if (game.IsBad(game.Obstacle(n)) == bad)
+                    {
+                        Put16(out, Index(game.Obstacle(n)));
+                        written++;
+                    }
+                }
+
+                out[count] = uint8_t(written);
+                out[count + 1] = uint8_t(written >> 8);
+            }
+        }
+
+        static Event Code(typename Game<width, height>::EventType type)
+        {
+            using Type = typename Game<width, height>::EventType;
+
+            switch (type)
+            {
+                case Type::HeadAdded:        return Event::HeadAdded;
+                case Type::TailRemoved:      return Event::TailRemoved;
+                case Type::BodyAppended:     return Event::BodyAppended;
+                case Type::GoodSpawned:      return Event::GoodSpawned;
+                case Type::BadSpawned:       return Event::BadSpawned;
+                case Type::ObstaclesCleared: return Event::ObstaclesCleared;
+            }
+
+            throw std::logic_error("Game event with no code in the delta stream");
+        }
+
+        static uint16_t Index(const Coordinates& c)
+        {
+            return uint16_t(c.second * width + c.first);
+        }
+
+        static void Put16(std::vector<uint8_t>& out, uint16_t value)
+        {
+            out.push_back(uint8_t(value));
+            out.push_back(uint8_t(value >> 8));
+        }
+
+        static void Put32(std::vector<uint8_t>& out, uint32_t value)
+        {
+            Put16(out, uint16_t(value));
+            Put16(out, uint16_t(value >> 16));
+        }
+    };
+
+    // Rebuilds the state a stream describes. Deltas read before the first keyframe
+    // are skipped, since there is nothing yet to apply them to.
+    template <int width, int height>
+    class Decoder
+    {
+    public:
+        Decoder() :
+            _synced(false),
+            _alive(false),
+            _tickCount(0),
+            _score(0)
+        {}
+
+        // Reads one frame. Returns the bytes it used, or 0 if the frame is not
+        // complete yet. Throws, leaving the state as it was, on a frame it cannot
+        // make sense of
+        size_t Decode(const uint8_t* data, size_t size)
+        {
+            Reader reader{data, data + size};
+
+            if (size == 0)
+            {
+                return 0;
+            }
+
+            auto tag = reader.Get8();
+
+            if (tag == Keyframe)
+            {
+                return DecodeKeyframe(reader) ? size_t(reader.at - data) : 0;
+            }
+
+            if (tag == Delta)
+            {
+                return DecodeDelta(reader) ? size_t(reader.at - data) : 0;
+            }
+
+            throw std::runtime_error("Unknown frame in delta stream");
+        }
+
+        bool Synced() const
+        {
+            return _synced;
+        }
+
+        bool Alive() const
+        {
+            return _alive;
+        }
+
+        size_t TickCount() const
+        {
+            return _tickCount;
+        }
+
+        size_t Score() const
+        {
+            return _score;
+        }
+
+        size_t Length() const
+        {
+            return _snake.size();
+        }
+
+        // Body(0) is the head
+        Coordinates Body(size_t n) const
+        {
+            return _snake[n];
+        }
+
+        size_t ObstacleCount() const
+        {
+            return _obstacles.size();
+        }
+
+        Coordinates Obstacle(size_t n) const
+        {
+            return _obstacles[n].first;
+        }
+
+        bool IsBad(size_t n) const
+        {
+            return _obstacles[n].second;
+        }
+
+    private:
+        struct Reader
+        {
+            const uint8_t* at;
+            const uint8_t* end;
+
+            bool Has(size_t n) const
+            {
+                return size_t(end - at) >= n;
+            }
+
+            uint8_t Get8()
+            {
+                return *at++;
+            }
+
+            uint16_t Get16()
+            {
+                auto value = uint16_t(at[0] | at[1] << 8);
+                at += 2;
+                return value;
+            }
+
+            uint32_t Get32()
+            {
+                auto low = Get16();
+                return low | uint32_t(Get16()) << 16;
+            }
+
+            Coordinates GetCell()
+            {
+                auto index = Get16();
+
+                if (index >= width * height)
+                {
+                    throw std::runtime_error("Delta stream cell is off the board");
+                }
+
+                return std::make_pair(index % width, index / width);
+            }
+        };
+
+        bool _synced;
+        bool _alive;
+        size_t _tickCount;
+        size_t _score;
+        std::deque<Coordinates> _snake;
+        std::vector<std::pair<Coordinates, bool>> _obstacles;
+
+        // The frame is only applied once all of it has arrived
+        bool DecodeKeyframe(Reader& reader)
+        {
+            auto start = reader;
+
+            if (!reader.Has(4 + 1 + 4 + 2))
+            {
+                return false;
+            }
+
+            reader.at += 9;
+            size_t length = reader.Get16();
+
+            if (!reader.Has(length * 2 + 2))
+            {
+                return false;
+            }
+
+            reader.at += length * 2;
+            size_t good = reader.Get16();
+
+            if (!reader.Has(good * 2 + 2))
+            {
+                return false;
+            }
+
+            reader.at += good * 2;
+            size_t bad = reader.Get16();
+
+            if (!reader.Has(bad * 2))
+            {
+                return false;
+            }
+
+            // Read aside, so a bad cell leaves the state as it was
+            reader = start;
+            auto tickCount = reader.Get32();
+            auto alive = reader.Get8();
+            auto score = reader.Get32();
+            reader.Get16();
+
+            std::deque<Coordinates> snake;
+            for (size_t n = 0; n < length; n++)
+            {
+                snake.push_back(reader.GetCell());
+            }
+
+            std::vector<std::pair<Coordinates, bool>> obstacles;
+            reader.Get16();
+            for (size_t n = 0; n < good; n++)
+            {
+                obstacles.emplace_back(reader.GetCell(), false);
+            }
+
+            reader.Get16();
+            for (size_t n = 0; n < bad; n++)
+            {
+                obstacles.emplace_back(reader.GetCell(), true);
+            }
+
+            _tickCount = tickCount;
+            _alive = alive;
+            _score = score;
+            _snake.swap(snake);
+            _obstacles.swap(obstacles);
+            _synced = true;
+            return true;
+        }
+
+        bool DecodeDelta(Reader& reader)
+        {
+            if (!reader.Has(4 + 1 + 1))
+            {
+                return false;
+            }
+
+            auto tickCount = reader.Get32();
+            auto alive = reader.Get8();
+            size_t count = reader.Get8();
+
+            if (!reader.Has(count * 3))
+            {
+                return false;
+            }
+
+            if (!_synced)
+            {
+                reader.at += count * 3;
+                return true;
+            }
+
+            // Every event is read and checked before any is applied, which costs a
+            // second pass over the events rather than a copy of the state
+            auto events = reader;
+            auto length = _snake.size();
+
+            for (size_t n = 0; n < count; n++)
+            {
+                auto kind = Event(reader.Get8());
+                reader.GetCell();
+
+                switch (kind)
+                {
+                    case Event::HeadAdded:
+                    case Event::BodyAppended:
+                        length++;
+                        break;
+
+                    case Event::TailRemoved:
+                        if (length-- == 0)
+                        {
+                            throw std::runtime_error("Delta stream removes a tail from an empty snake");
+                        }
+                        break;
+
+                    case Event::GoodSpawned:
+                    case Event::BadSpawned:
+                    case Event::ObstaclesCleared:
+                        break;
+
+                    default:
+                        throw std::runtime_error("Unknown event in delta stream");
+                }
+            }
+
+            _tickCount = tickCount;
+            _alive = alive;
+
+            for (size_t n = 0; n < count; n++)
+            {
+                auto kind = Event(events.Get8());
+                auto c = events.GetCell();
+
+                // Obstacles only spawn on empty cells, so each spawn is a new entry
+                switch (kind)
+                {
+                    case Event::HeadAdded:        _snake.push_front(c); break;
+                    case Event::TailRemoved:      _snake.pop_back(); break;
+                    case Event::BodyAppended:     _snake.push_back(c); break;
+                    case Event::GoodSpawned:      _obstacles.emplace_back(c, false); break;
+                    case Event::BadSpawned:       _obstacles.emplace_back(c, true); break;
+                    case Event::ObstaclesCleared: _obstacles.clear(); _score++; break;
+                }
+            }
+
+            return true;
+        }
+    };
+}
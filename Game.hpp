@@ -0,0 +1,726 @@
+#pragma once
+
+#include "Bitboard.hpp"
+#include "Level.hpp"
+#include "TimingWheel.hpp"
+
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+class GameOver :
+        public std::exception
+{
+public:
+    GameOver(std::string what) :
+        _what(what)
+    {}
+
+    const char* what() const noexcept final override
+    {
+        return _what.c_str();
+    }
+
+private:
+    std::string _what;
+};
+
+using Coordinates = std::pair<int, int>;
+
+// Packed position for fixed-size state; converts to Coordinates for everyone else
+struct Cell
+{
+    int16_t x;
+    int16_t y;
+
+    constexpr operator Coordinates() const
+    {
+        return std::make_pair(int(x), int(y));
+    }
+};
+
+enum class Direction
+{
+    North,
+    East,
+    South,
+    West
+};
+
+// The rules of snake without any drawing, so the same game can run behind the
+// engine, in a bot or in a test. Every cell change made by the last Tick() is
+// logged in Events() for consumers that track the board incrementally.
+//
+// All state lives in fixed-size members, so a Game is trivially copyable and a
+// snapshot is a single memcpy. A 64-bit Zobrist hash of the position is kept up
+// to date as the state changes, and so is a bitboard of the free cells for
+// reachability queries. Walls are a bitboard too: the border, or whatever a Level
+// draws. What happens on a schedule, such as growing and spawning
+// obstacles, is kept on a timing wheel, so a tick only pays for what falls due.
+template <int width, int height>
+class Game
+{
+public:
+    static constexpr int Cells = width * height;
+    static_assert(Cells <= UINT16_MAX, "Obstacle cells are stored as 16 bits");
+
+    enum class EventType
+    {
+        HeadAdded,
+        TailRemoved,
+        // Not produced by Tick(), which grows by keeping the tail; kept for consumers
+        // that describe a whole body as appended cells
+        BodyAppended,
+        GoodSpawned,
+        BadSpawned,
+        ObstaclesCleared
+    };
+
+    struct Event
+    {
+        EventType type;
+        Cell cell;
+    };
+
+    // Enough for the busiest tick: move, eat and spawn twice
+    class EventLog
+    {
+    public:
+        const Event* begin() const
+        {
+            return _events.data();
+        }
+
+        const Event* end() const
+        {
+            return _events.data() + _count;
+        }
+
+        constexpr size_t size() const
+        {
+            return _count;
+        }
+
+    private:
+        friend class Game;
+        std::array<Event, 16> _events;
+        uint8_t _count;
+    };
+
+    Game() :
+        Game(Border())
+    {}
+
+    // A new game on a level's walls. Its zones and portals are left to the modes
+    // that use them
+    explicit Game(const Level& level) :
+        Game(LevelWalls(level))
+    {}
+
+    // A new game inside walls that leave the snake's starting cells clear
+    explicit Game(const Bitboard<width, height>& walls)
+    {
+        static_assert(sizeof(Game) <= Cells * 8 + 1024, "A game is copied whole, so it is its board and little else");
+
+        Build(walls);
+        Start();
+    }
+
+    // Starts a new game in place, on the same walls and in the same storage. Only
+    // the cells the last game left the snake and obstacles on are cleared, so a
+    // restart costs as much as they do rather than the whole board
+    void Reset(uint64_t seed)
+    {
+        for (size_t n = 0; n < _length; n++)
+        {
+            ClearCell(Body(n));
+        }
+
+        for (size_t n = 0; n < _obstacleCount; n++)
+        {
+            ClearCell(Obstacle(n));
+        }
+
+        Start();
+        Seed(seed);
+    }
+
+    // As Reset(seed), but on new walls
+    void Reset(uint64_t seed, const Bitboard<width, height>& walls)
+    {
+        Build(walls);
+        Start();
+        Seed(seed);
+    }
+
+    static constexpr int Width()
+    {
+        return width;
+    }
+
+    static constexpr int Height()
+    {
+        return height;
+    }
+
+    static constexpr bool IsBorder(int x, int y)
+    {
+        return x == 0 || x == width - 1 || y == 0 || y == height - 1;
+    }
+
+    static constexpr bool InBounds(const Coordinates& c)
+    {
+        return c.first >= 0 && c.first < width && c.second >= 0 && c.second < height;
+    }
+
+    constexpr bool IsWall(const Coordinates& c) const
+    {
+        return InBounds(c) && _walls.Test(c);
+    }
+
+    const Bitboard<width, height>& Walls() const
+    {
+        return _walls;
+    }
+
+    // True for walls, the snake and bad obstacles
+    constexpr bool IsBlocked(const Coordinates& c) const
+    {
+        return !InBounds(c) || _walls.Test(c) || (_cells[Index(c)] & (BodyMask | Bad));
+    }
+
+    // Cells that are not walls nor taken by the snake or a bad obstacle
+    const Bitboard<width, height>& Free() const
+    {
+        return _free;
+    }
+
+    // Free cells reachable from c, which itself may be blocked, such as the head
+    Bitboard<width, height> Reachable(const Coordinates& c) const
+    {
+        Bitboard<width, height> seed;
+        seed.Set(c);
+        return Bitboard<width, height>::Fill(seed, _free) & _free;
+    }
+
+    constexpr bool IsGood(const Coordinates& c) const
+    {
+        return InBounds(c) && (_cells[Index(c)] & Good);
+    }
+
+    constexpr bool IsBad(const Coordinates& c) const
+    {
+        return InBounds(c) && (_cells[Index(c)] & Bad);
+    }
+
+    constexpr Direction GetDirection() const
+    {
+        return _currentDirection;
+    }
+
+    constexpr void SetDirection(Direction direction)
+    {
+        _hash ^= Key(DirectionFeature + int(_currentDirection)) ^ Key(DirectionFeature + int(direction));
+        _currentDirection = direction;
+    }
+
+    constexpr size_t Length() const
+    {
+        return _length;
+    }
+
+    // Body(0) is the head, Body(Length() - 1) the tail
+    constexpr Coordinates Body(size_t n) const
+    {
+        return _snake[Wrap(_head + n)];
+    }
+
+    constexpr Coordinates Head() const
+    {
+        return Body(0);
+    }
+
+    constexpr Coordinates Tail() const
+    {
+        return Body(_length - 1);
+    }
+
+    // Obstacles only appear on empty cells, so each is on a cell of its own
+    constexpr size_t ObstacleCount() const
+    {
+        return _obstacleCount;
+    }
+
+    constexpr Coordinates Obstacle(size_t n) const
+    {
+        return std::make_pair(int(_obstacles[n] % width), int(_obstacles[n] / width));
+    }
+
+    // What the snake grows by for a good obstacle, and the ticks between the
+    // single cells it grows by regardless
+    static constexpr size_t MealGrowth = 5;
+    static constexpr size_t GrowEvery = 10;
+
+    // Cells the snake has yet to grow by. It grows one a tick by keeping its tail
+    constexpr size_t PendingGrowth() const
+    {
+        return _growth;
+    }
+
+    const EventLog& Events() const
+    {
+        return _events;
+    }
+
+    constexpr size_t TickCount() const
+    {
+        return _tickCount;
+    }
+
+    // Good obstacles eaten
+    constexpr size_t Score() const
+    {
+        return _score;
+    }
+
+    // Covers the cells under the body, the head, the obstacles, the direction, the
+    // growth still owed and the tick within the growth and spawn cycle. Equal positions hash equally
+    // however they were reached; the RNG state is left out.
+    constexpr uint64_t Hash() const
+    {
+        return _hash ^ _bodyHash;
+    }
+
+    constexpr void Seed(uint64_t seed)
+    {
+        _random = seed;
+    }
+
+    // entropy decides where obstacles appear; without it the game draws its own
+    void Tick(size_t entropy)
+    {
+        if (!TryTick(entropy))
+        {
+            throw GameOver("Collision");
+        }
+    }
+
+    void Tick()
+    {
+        Tick(size_t(NextRandom()));
+    }
+
+    // As Tick(), but reports a collision by returning false, for search and rollouts
+    bool TryTick(size_t entropy)
+    {
+        _events._count = 0;
+
+        FollowTheSnakeHead();
+
+        if (!MoveTheSnakeHead(entropy))
+        {
+            return false;
+        }
+
+        _timers.Advance([this, entropy](uint32_t timer)
+        {
+            switch (Timer(timer))
+            {
+                case Timer::Grow:
+                    GrowTheSnake(1);
+                    _timers.Schedule(uint32_t(_tickCount + GrowEvery), timer);
+                    break;
+
+                case Timer::Spawn:
+                    CreateObstacle(entropy);
+                    _timers.Schedule(uint32_t(_tickCount + SpawnEvery), timer);
+                    break;
+            }
+        });
+
+        _hash ^= Key(PhaseFeature + _tickCount % SpawnEvery);
+        _tickCount++;
+        _hash ^= Key(PhaseFeature + _tickCount % SpawnEvery);
+        return true;
+    }
+
+    bool TryTick()
+    {
+        return TryTick(size_t(NextRandom()));
+    }
+
+private:
+    // Each cell counts the body parts on it and flags the obstacles on it
+    static constexpr uint8_t BodyMask = 0x3F;
+    static constexpr uint8_t Good = 0x40;
+    static constexpr uint8_t Bad = 0x80;
+
+    static constexpr size_t SpawnEvery = 30;
+    static_assert(SpawnEvery % GrowEvery == 0, "The tick phase hashed covers both schedules");
+
+    // The wheel is copied with every game, so it holds the growth and spawn timers
+    // with room to spare, on two wheels whose 4095 ticks of reach cover either delay
+    static constexpr size_t Timers = 4;
+    static constexpr int TimerLevels = 2;
+
+    enum class Timer : uint32_t
+    {
+        Grow,
+        Spawn
+    };
+
+    // Zobrist features: four per cell, then the directions and the tick phases
+    static constexpr uint64_t BodyFeature = 0;
+    static constexpr uint64_t HeadFeature = 1;
+    static constexpr uint64_t GoodFeature = 2;
+    static constexpr uint64_t BadFeature = 3;
+    static constexpr uint64_t DirectionFeature = uint64_t(Cells) * 4;
+    static constexpr uint64_t PhaseFeature = DirectionFeature + 4;
+    static constexpr uint64_t GrowthFeature = PhaseFeature + SpawnEvery;
+
+    std::array<Cell, Cells> _snake;
+    std::array<uint8_t, Cells> _cells;
+    std::array<uint16_t, Cells> _obstacles;
+    Bitboard<width, height> _free;
+    Bitboard<width, height> _walls;
+    uint32_t _head;
+    uint32_t _length;
+    uint32_t _growth;
+    uint32_t _obstacleCount;
+    EventLog _events;
+    Direction _currentDirection;
+    uint64_t _random;
+    size_t _tickCount;
+    size_t _score;
+    uint64_t _hash;
+    // Body cells are summed rather than xored, so a cell covered twice still counts
+    uint64_t _bodyHash;
+    TimingWheel<Timers, TimerLevels> _timers;
+
+    static Bitboard<width, height> LevelWalls(const Level& level)
+    {
+        if (level.Width() != width || level.Height() != height)
+        {
+            throw std::invalid_argument("Level is not the size of the game");
+        }
+
+        Bitboard<width, height> walls;
+        walls.Load(level.Walls());
+        return walls;
+    }
+
+    static constexpr size_t Index(const Coordinates& c)
+    {
+        return size_t(c.second * width + c.first);
+    }
+
+    static constexpr size_t Wrap(size_t n)
+    {
+        return n < size_t(Cells) ? n : n - Cells;
+    }
+
+    static constexpr Cell MakeCell(const Coordinates& c)
+    {
+        return {int16_t(c.first), int16_t(c.second)};
+    }
+
+    // The splitmix64 finalizer spreads a feature number into a key, so no table is needed
+    static constexpr uint64_t Key(uint64_t feature)
+    {
+        uint64_t z = (feature + 1) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr uint64_t CellKey(size_t index, uint64_t feature)
+    {
+        return Key(index * 4 + feature);
+    }
+
+    // splitmix64
+    constexpr uint64_t NextRandom()
+    {
+        uint64_t z = (_random += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    void Record(EventType type, const Coordinates& c)
+    {
+        _events._events[_events._count++] = {type, MakeCell(c)};
+
+        if (!InBounds(c))
+        {
+            return;
+        }
+
+        switch (type)
+        {
+            case EventType::HeadAdded:
+            case EventType::BodyAppended: _cells[Index(c)]++; _bodyHash += CellKey(Index(c), BodyFeature); break;
+            case EventType::TailRemoved:  _cells[Index(c)]--; _bodyHash -= CellKey(Index(c), BodyFeature); break;
+            default: break;
+        }
+
+        UpdateFree(Index(c));
+    }
+
+    constexpr void UpdateFree(size_t index)
+    {
+        auto c = std::make_pair(int(index % width), int(index / width));
+        _free.Assign(c, !_walls.Test(c) && !(_cells[index] & (BodyMask | Bad)));
+    }
+
+    template <typename T>
+    void MoveNorth(T& x)
+    {
+        x--;
+    }
+
+    template <typename T>
+    void MoveSouth(T& x)
+    {
+        x++;
+    }
+
+    template <typename T>
+    void MoveEast(T& y)
+    {
+        y++;
+    }
+
+    template <typename T>
+    void MoveWest(T& y)
+    {
+        y--;
+    }
+
+    constexpr void Step(Coordinates& c)
+    {
+        switch (_currentDirection)
+        {
+            case Direction::North: MoveNorth(c.second); break;
+            case Direction::East:  MoveEast(c.first); break;
+            case Direction::South: MoveSouth(c.second); break;
+            case Direction::West:  MoveWest(c.first); break;
+        }
+    }
+
+    static Bitboard<width, height> Border()
+    {
+        Bitboard<width, height> walls;
+
+        for (int x = 0; x < width; x++)
+        {
+            walls.Set(std::make_pair(x, 0));
+            walls.Set(std::make_pair(x, height - 1));
+        }
+
+        for (int y = 0; y < height; y++)
+        {
+            walls.Set(std::make_pair(0, y));
+            walls.Set(std::make_pair(width - 1, y));
+        }
+
+        return walls;
+    }
+
+    void Build(const Bitboard<width, height>& walls)
+    {
+        _walls = walls;
+        _free = Bitboard<width, height>();
+        _cells.fill(0);
+
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                if (!walls.Test(std::make_pair(x, y)))
+                {
+                    _free.Set(std::make_pair(x, y));
+                }
+            }
+        }
+    }
+
+    void ClearCell(const Coordinates& c)
+    {
+        if (InBounds(c))
+        {
+            _cells[Index(c)] = 0;
+            UpdateFree(Index(c));
+        }
+    }
+
+    // Everything but the board, as a new game has it
+    void Start()
+    {
+        _head = 0;
+        _length = 0;
+        _growth = 0;
+        _obstacleCount = 0;
+        _events._count = 0;
+        _currentDirection = Direction::North;
+        _random = 0;
+        _tickCount = 0;
+        _score = 0;
+        _hash = Key(DirectionFeature + int(Direction::North)) ^ Key(PhaseFeature);
+        _bodyHash = 0;
+        _timers.Clear();
+
+        CreateInitialSnake();
+
+        for (size_t n = 0; n < _length; n++)
+        {
+            if (IsWall(Body(n)))
+            {
+                throw std::invalid_argument("Level has a wall where the snake starts");
+            }
+        }
+
+        _timers.Schedule(0, uint32_t(Timer::Grow));
+        _timers.Schedule(0, uint32_t(Timer::Spawn));
+    }
+
+    void CreateInitialSnake()
+    {
+        for (int n = 0; n < 5; n++)
+        {
+            _snake[_length++] = MakeCell(std::make_pair(width / 2, height / 2 + n));
+            _cells[Index(Tail())]++;
+            _bodyHash += CellKey(Index(Tail()), BodyFeature);
+            UpdateFree(Index(Tail()));
+        }
+
+        _hash ^= CellKey(Index(Head()), HeadFeature);
+    }
+
+    void SetObstacle(size_t index, uint8_t flag)
+    {
+        if (!(_cells[index] & flag))
+        {
+            _cells[index] |= flag;
+            _hash ^= CellKey(index, flag == Good ? GoodFeature : BadFeature);
+            UpdateFree(index);
+        }
+    }
+
+    void ClearObstacles()
+    {
+        for (uint32_t n = 0; n < _obstacleCount; n++)
+        {
+            auto index = _obstacles[n];
+
+            if (_cells[index] & Good)
+            {
+                _hash ^= CellKey(index, GoodFeature);
+            }
+
+            if (_cells[index] & Bad)
+            {
+                _hash ^= CellKey(index, BadFeature);
+            }
+
+            _cells[index] &= BodyMask;
+            UpdateFree(index);
+        }
+
+        _obstacleCount = 0;
+    }
+
+    // Growth is owed rather than appended, so the body only ever grows where the
+    // head has been
+    void GrowTheSnake(int x)
+    {
+        _hash ^= Key(GrowthFeature + _growth);
+        _growth += uint32_t(x);
+        _hash ^= Key(GrowthFeature + _growth);
+    }
+
+    bool MoveTheSnakeHead(size_t entropy)
+    {
+        auto head = Head();
+        Step(head);
+
+        _head = _head == 0 ? Cells - 1 : _head - 1;
+        _snake[_head] = MakeCell(head);
+        _hash ^= CellKey(Index(Body(1)), HeadFeature) ^ CellKey(Index(head), HeadFeature);
+        _length++;
+        Record(EventType::HeadAdded, head);
+
+        return CheckCollosion(entropy);
+    }
+
+    bool CheckCollosion(size_t entropy)
+    {
+        auto head = Head();
+        auto cell = _cells[Index(head)];
+
+        if (_walls.Test(head) || (cell & BodyMask) > 1 || (cell & Bad))
+        {
+            return false;
+        }
+
+        if (cell & Good)
+        {
+            ClearObstacles();
+            _score++;
+            Record(EventType::ObstaclesCleared, head);
+            GrowTheSnake(int(MealGrowth));
+
+            CreateObstacle(entropy);
+        }
+
+        return true;
+    }
+
+    // The head moves on by taking a new slot at the front of the ring, so the rest
+    // of the body only has to give up its tail
+    void FollowTheSnakeHead()
+    {
+        if (_growth > 0)
+        {
+            GrowTheSnake(-1);
+            return;
+        }
+
+        Record(EventType::TailRemoved, Tail());
+        _length--;
+    }
+
+    // The cell drawn may be taken, by a wall, the snake or another obstacle, in
+    // which case the obstacle goes on the next empty cell after it
+    void CreateObstacle(size_t entropy)
+    {
+        auto index = Index(std::make_pair(int(uint64_t(entropy) % width), int((uint64_t(entropy) >> 32) % height)));
+
+        for (int n = 0; _walls.Test(std::make_pair(int(index % width), int(index / width))) || _cells[index]; n++)
+        {
+            if (n == Cells)
+            {
+                return;
+            }
+
+            index = Wrap(index + 1);
+        }
+
+        auto c = std::make_pair(int(index % width), int(index / width));
+        _obstacles[_obstacleCount++] = uint16_t(index);
+
+        if ((uint64_t(entropy) >> 16) % 3 == 0)
+        {
+            SetObstacle(index, Good);
+            Record(EventType::GoodSpawned, c);
+        }
+        else
+        {
+            SetObstacle(index, Bad);
+            Record(EventType::BadSpawned, c);
+        }
+    }
+};
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "Game.hpp"
+
+#include <array>
+#include <cstdint>
+
+// A pilot that follows a Hamiltonian cycle through every cell inside the border,
+// laid out at compile time. It only ever moves forward along the cycle and never
+// past the tail, so while the body lies in cycle order it cannot run into itself.
+// That is a heuristic, not a guarantee: the snake grows until it no longer fits,
+// and bad obstacles land on the cycle in front of it. It steps round them to the
+// nearest free cell ahead, leaves the cycle early where the cycle would only run
+// into one, and takes shortcuts towards food while it is short, as long as they
+// leave room for all the growth it can see coming. Boxed in, it goes where the
+// most free cells can be reached.
+//
+// A move looks up each neighbour and passes over the obstacles. A bad obstacle
+// ahead adds a walk back from it, no longer than the last row and the column
+// back, and a flood fill is left for when no forward move remains.
+template <int width, int height>
+class Hamiltonian
+{
+public:
+    static constexpr int Columns = width - 2;
+    static constexpr int Rows = height - 2;
+    static constexpr int Cells = Columns * Rows;
+
+    static_assert(Columns >= 2 && Rows >= 2, "Hamiltonian needs at least 2x2 cells inside the border");
+    static_assert(Cells % 2 == 0, "A grid with an odd number of cells has no Hamiltonian cycle");
+    static_assert(width * height < UINT16_MAX, "Cycle positions are stored as 16 bits");
+
+    // Position of a cell along the cycle, or NotOnCycle for the border and beyond
+    static constexpr uint16_t NotOnCycle = UINT16_MAX;
+
+    static constexpr uint16_t Order(const Coordinates& c)
+    {
+        return Game<width, height>::InBounds(c) ? _order[c.second * width + c.first] : NotOnCycle;
+    }
+
+    static Direction Steer(const Game<width, height>& game)
+    {
+        using Rules = Game<width, height>;
+        auto head = Order(game.Head());
+
+        if (head == NotOnCycle)
+        {
+            return game.GetDirection();
+        }
+
+        // The cells free to move into before reaching the tail
+        auto tail = Ahead(head, game.Tail());
+        int gap = tail == 0 ? Cells : tail;
+
+        // A shortcut to a leaves gap - a cells for the head to cover before it comes
+        // round to the tail, and those have to hold the growth owed, a meal and a
+        // cell for every GrowEvery ticks on the way
+        auto room = [&game, gap](int a)
+        {
+            return gap - a > int(game.PendingGrowth() + Rules::MealGrowth + size_t(gap - a) / Rules::GrowEvery + 1);
+        };
+
+        bool shortcuts = int(game.Length() + game.PendingGrowth()) < Cells / 2;
+        int food = Cells;
+        int bad = Cells;
+
+        for (size_t n = 0; n < game.ObstacleCount(); n++)
+        {
+            auto c = game.Obstacle(n);
+            auto f = Ahead(head, c);
+
+            if (game.IsGood(c) && f > 0 && f < food)
+            {
+                food = f;
+            }
+
+            if (game.IsBad(c) && f > 0 && f < bad)
+            {
+                bad = f;
+            }
+        }
+
+        // The cycle's next cell, else the furthest shortcut that stops short of the
+        // food, else the nearest cell past whatever blocks the cycle. Apart from
+        // those, the nearest cell past the first bad obstacle
+        Direction choice = game.GetDirection();
+        int chosen = 0;
+        Direction nearest = choice;
+        int nearestAhead = 0;
+        Direction past = choice;
+        int pastAhead = 0;
+
+        for (auto direction : {Direction::North, Direction::East, Direction::South, Direction::West})
+        {
+            auto c = Neighbour(game.Head(), direction);
+            int a = Ahead(head, c);
+
+            if (!Open(game, c) || a == 0 || a > gap)
+            {
+                continue;
+            }
+
+            if (a == 1 || (shortcuts && a <= food && room(a) && chosen != 1 && a > chosen))
+            {
+                choice = direction;
+                chosen = a;
+            }
+
+            if (nearestAhead == 0 || a < nearestAhead)
+            {
+                nearest = direction;
+                nearestAhead = a;
+            }
+
+            if (a > bad && (pastAhead == 0 || a < pastAhead))
+            {
+                past = direction;
+                pastAhead = a;
+            }
+        }
+
+        if (chosen == 0)
+        {
+            choice = nearest;
+            chosen = nearestAhead;
+        }
+
+        if (chosen == 0)
+        {
+            return Roomiest(game);
+        }
+
+        // Where the cycle runs into the bad obstacle with no way round it, this is
+        // the last chance to get past
+        if (pastAhead > 0 && chosen < bad && !Passable(game, head, chosen, bad, gap))
+        {
+            return past;
+        }
+
+        return choice;
+    }
+
+private:
+    // Steps along the cycle from the head to c, or 0 for cells off the cycle
+    static constexpr int Ahead(uint16_t head, const Coordinates& c)
+    {
+        auto order = Order(c);
+        return order == NotOnCycle ? 0 : (order + Cells - head) % Cells;
+    }
+
+    // True if a cell on the cycle between a steps ahead of the head and the bad
+    // obstacle has a free neighbour past it. Looks back from the obstacle, where
+    // the way round usually is, and only as far as the longest run of the cycle
+    // with no way off
+    static bool Passable(const Game<width, height>& game, uint16_t head, int a, int bad, int gap)
+    {
+        for (int n = bad - 1; n >= a && n >= bad - Columns - Rows; n--)
+        {
+            auto index = _path[(head + n) % Cells];
+            Coordinates c{index % width, index / width};
+
+            for (auto direction : {Direction::North, Direction::East, Direction::South, Direction::West})
+            {
+                auto way = Neighbour(c, direction);
+                auto b = Ahead(head, way);
+
+                if (b > bad && b < gap && !game.IsBlocked(way))
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    static constexpr Coordinates Neighbour(const Coordinates& c, Direction direction)
+    {
+        switch (direction)
+        {
+            case Direction::North: return {c.first, c.second - 1};
+            case Direction::East:  return {c.first + 1, c.second};
+            case Direction::South: return {c.first, c.second + 1};
+            case Direction::West:  return {c.first - 1, c.second};
+        }
+
+        return c;
+    }
+
+    // The tail moves off its cell as the head moves on, unless the snake is growing
+    static bool Open(const Game<width, height>& game, const Coordinates& c)
+    {
+        return !game.IsBlocked(c) || (c == game.Tail() && game.PendingGrowth() == 0);
+    }
+
+    // Free cells the head could reach by moving that way, counting the one it moves to
+    static size_t Room(const Game<width, height>& game, Direction direction)
+    {
+        auto c = Neighbour(game.Head(), direction);
+        return Open(game, c) ? game.Reachable(c).Count() + (game.IsBlocked(c) ? 1 : 0) : 0;
+    }
+
+    // No move forward along the cycle is open, so go where the most free cells can be reached
+    static Direction Roomiest(const Game<width, height>& game)
+    {
+        auto best = game.GetDirection();
+        size_t bestRoom = 0;
+
+        for (auto direction : {Direction::North, Direction::East, Direction::South, Direction::West})
+        {
+            auto room = Room(game, direction);
+
+            if (room > bestRoom)
+            {
+                best = direction;
+                bestRoom = room;
+            }
+        }
+
+        return best;
+    }
+
+    // Zigzag along the even dimension and come back along the first row or column
+    static constexpr std::array<uint16_t, width * height> Build()
+    {
+        std::array<uint16_t, width * height> order{};
+        uint16_t k = 0;
+
+        for (auto& o : order)
+        {
+            o = NotOnCycle;
+        }
+
+        auto put = [&order, &k](int column, int row)
+        {
+            order[(row + 1) * width + column + 1] = k++;
+        };
+
+        if (Rows % 2 == 0)
+        {
+            for (int row = 0; row < Rows; row++)
+            {
+                for (int n = 1; n < Columns; n++)
+                {
+                    put(row % 2 == 0 ? n : Columns - n, row);
+                }
+            }
+
+            for (int row = Rows - 1; row >= 0; row--)
+            {
+                put(0, row);
+            }
+        }
+        else
+        {
+            for (int column = 0; column < Columns; column++)
+            {
+                for (int n = 1; n < Rows; n++)
+                {
+                    put(column, column % 2 == 0 ? n : Rows - n);
+                }
+            }
+
+            for (int column = Columns - 1; column >= 0; column--)
+            {
+                put(column, 0);
+            }
+        }
+
+        return order;
+    }
+
+    // The cell at each position along the cycle
+    static constexpr std::array<uint16_t, Cells> Trace()
+    {
+        std::array<uint16_t, Cells> path{};
+
+        for (int index = 0; index < width * height; index++)
+        {
+            if (_order[index] != NotOnCycle)
+            {
+                path[_order[index]] = uint16_t(index);
+            }
+        }
+
+        return path;
+    }
+
+    static constexpr std::array<uint16_t, width * height> _order = Build();
+    static constexpr std::array<uint16_t, Cells> _path = Trace();
+};
@@ -0,0 +1,501 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A board designed ahead of time: walls anywhere rather than only round the edge,
+// zones where things start, and portals that join two cells. A design is compiled
+// once into a binary file laid out the way a game uses it. Loading maps the file
+// and checks that everything in it is in bounds, so nothing is parsed and switching
+// levels costs little more than the page faults. The walls are kept in Bitboard's
+// layout, so a game takes them with one copy and tests a wall with one bit.
+//
+// Numbers are little-endian, every section starts on a 64-byte boundary and a cell
+// is its u16 index y * width + x. Version 1:
+//   header      64 bytes, as Header
+//   walls       u64 words, width / 64 + 1 per row for height + 2 rows, of which the
+//               first and last are empty, as in Bitboard
+//   free        u16 cells that are not walls, in order
+//   zones       u32 first, u32 count for each zone, into the zone cells
+//   zone cells  u16 cells
+//   portals     u16 cell, u16 cell for each portal, which joins them both ways
+class Level
+{
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Levels are mapped as they are stored");
+
+public:
+    using Cell = std::pair<int, int>;
+
+    static constexpr uint16_t Version = 1;
+
+    // What a designer draws, for Save() to compile
+    struct Design
+    {
+        int width;
+        int height;
+        // One for each cell, y * width + x
+        std::vector<bool> walls;
+        std::vector<std::vector<Cell>> zones;
+        std::vector<std::pair<Cell, Cell>> portals;
+    };
+
+    explicit Level(const std::string& path)
+    {
+        auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) < 0)
+        {
+            auto error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "fstat " + path);
+        }
+
+        _size = size_t(info.st_size);
+
+        if (_size < sizeof(Header))
+        {
+            close(fd);
+            throw std::runtime_error("Level " + path + " is too short");
+        }
+
+        auto memory = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        auto error = errno;
+        close(fd);
+
+        if (memory == MAP_FAILED)
+        {
+            throw std::system_error(error, std::generic_category(), "mmap " + path);
+        }
+
+        _data = static_cast<const uint8_t*>(memory);
+
+        try
+        {
+            Validate();
+        }
+        catch (std::runtime_error& e)
+        {
+            munmap(const_cast<uint8_t*>(_data), _size);
+            throw std::runtime_error("Level " + path + " " + e.what());
+        }
+    }
+
+    ~Level()
+    {
+        munmap(const_cast<uint8_t*>(_data), _size);
+    }
+
+    Level(const Level&) = delete;
+    Level& operator=(const Level&) = delete;
+
+    int Width() const
+    {
+        return GetHeader().width;
+    }
+
+    int Height() const
+    {
+        return GetHeader().height;
+    }
+
+    bool IsWall(int x, int y) const
+    {
+        return Walls()[size_t(y + 1) * GetHeader().rowWords + size_t(x / 64)] >> (x % 64) & 1;
+    }
+
+    // The walls as Bitboard<Width(), Height()> keeps its words
+    const uint64_t* Walls() const
+    {
+        return reinterpret_cast<const uint64_t*>(_data + GetHeader().walls);
+    }
+
+    size_t FreeCount() const
+    {
+        return GetHeader().freeCount;
+    }
+
+    Cell Free(size_t n) const
+    {
+        return Unpack(Cells(GetHeader().free)[n]);
+    }
+
+    size_t ZoneCount() const
+    {
+        return GetHeader().zoneCount;
+    }
+
+    size_t ZoneSize(size_t zone) const
+    {
+        return Zones()[zone].count;
+    }
+
+    Cell ZoneCell(size_t zone, size_t n) const
+    {
+        return Unpack(Cells(GetHeader().zoneCells)[Zones()[zone].first + n]);
+    }
+
+    size_t PortalCount() const
+    {
+        return GetHeader().portalCount;
+    }
+
+    std::pair<Cell, Cell> Portal(size_t n) const
+    {
+        auto* ends = Cells(GetHeader().portals) + n * 2;
+        return std::make_pair(Unpack(ends[0]), Unpack(ends[1]));
+    }
+
+    // Reads a design drawn in text, one line per row: '#' is a wall, '.' or ' ' is
+    // floor, a digit is floor in that zone and a letter is one end of a portal,
+    // whose other end is the same letter. Short lines are padded with floor
+    static Design Parse(std::istream& in)
+    {
+        std::vector<std::string> rows;
+        size_t width = 0;
+
+        for (std::string row; std::getline(in, row);)
+        {
+            if (!row.empty() && row.back() == '\r')
+            {
+                row.pop_back();
+            }
+
+            width = std::max(width, row.size());
+            rows.push_back(row);
+        }
+
+        Design design{int(width), int(rows.size()), std::vector<bool>(width * rows.size()), {}, {}};
+        std::vector<std::vector<Cell>> portals(26);
+
+        for (int y = 0; y < design.height; y++)
+        {
+            for (int x = 0; x < int(rows[y].size()); x++)
+            {
+                auto c = rows[y][x];
+
+                if (c == '#')
+                {
+                    design.walls[y * width + x] = true;
+                }
+                else if (c >= '0' && c <= '9')
+                {
+                    design.zones.resize(std::max(design.zones.size(), size_t(c - '0' + 1)));
+                    design.zones[c - '0'].emplace_back(x, y);
+                }
+                else if (c >= 'a' && c <= 'z')
+                {
+                    portals[c - 'a'].emplace_back(x, y);
+                }
+                else if (c != '.' && c != ' ')
+                {
+                    throw std::runtime_error("Unknown cell '" + std::string(1, c) + "' on line " + std::to_string(y + 1));
+                }
+            }
+        }
+
+        for (size_t n = 0; n < portals.size(); n++)
+        {
+            if (portals[n].empty())
+            {
+                continue;
+            }
+
+            if (portals[n].size() != 2)
+            {
+                throw std::runtime_error("Portal '" + std::string(1, char('a' + n)) + "' does not have two ends");
+            }
+
+            design.portals.emplace_back(portals[n][0], portals[n][1]);
+        }
+
+        return design;
+    }
+
+    // Compiles a design into a level file. The file is written aside and renamed
+    // over path, so a game that has the old one mapped keeps it
+    static void Save(const Design& design, const std::string& path)
+    {
+        auto width = design.width;
+        auto height = design.height;
+
+        if (width < 3 || height < 3 || width * height > UINT16_MAX || design.walls.size() != size_t(width * height))
+        {
+            throw std::invalid_argument("A level is at least 3x3 and at most 65535 cells");
+        }
+
+        auto wall = [&](const Cell& c) { return design.walls[size_t(c.second * width + c.first)]; };
+        auto index = [&](const Cell& c)
+        {
+            if (c.first < 0 || c.first >= width || c.second < 0 || c.second >= height || wall(c))
+            {
+                throw std::invalid_argument("Zones and portals must be on floor inside the level");
+            }
+
+            return uint16_t(c.second * width + c.first);
+        };
+
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                if ((x == 0 || x == width - 1 || y == 0 || y == height - 1) && !wall({x, y}))
+                {
+                    throw std::invalid_argument("A level must be walled all round");
+                }
+            }
+        }
+
+        Header header{};
+        std::memcpy(header.magic, Magic, sizeof(header.magic));
+        header.version = Version;
+        header.width = uint16_t(width);
+        header.height = uint16_t(height);
+        header.rowWords = uint16_t(width / 64 + 1);
+
+        std::vector<uint8_t> out(sizeof(Header));
+
+        header.walls = Section(out);
+        std::vector<uint64_t> words(size_t(header.rowWords) * size_t(height + 2));
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                if (wall({x, y}))
+                {
+                    words[size_t(y + 1) * header.rowWords + size_t(x / 64)] |= uint64_t(1) << (x % 64);
+                }
+            }
+        }
+        Append(out, words);
+
+        header.free = Section(out);
+        std::vector<uint16_t> free;
+        for (int n = 0; n < width * height; n++)
+        {
+            if (!design.walls[size_t(n)])
+            {
+                free.push_back(uint16_t(n));
+            }
+        }
+        header.freeCount = uint32_t(free.size());
+        Append(out, free);
+
+        header.zones = Section(out);
+        std::vector<Zone> zones;
+        std::vector<uint16_t> zoneCells;
+        for (auto& zone : design.zones)
+        {
+            zones.push_back({uint32_t(zoneCells.size()), uint32_t(zone.size())});
+
+            for (auto& c : zone)
+            {
+                zoneCells.push_back(index(c));
+            }
+        }
+        header.zoneCount = uint32_t(zones.size());
+        Append(out, zones);
+
+        header.zoneCells = Section(out);
+        header.zoneCellCount = uint32_t(zoneCells.size());
+        Append(out, zoneCells);
+
+        header.portals = Section(out);
+        std::vector<uint16_t> portals;
+        for (auto& portal : design.portals)
+        {
+            portals.push_back(index(portal.first));
+            portals.push_back(index(portal.second));
+        }
+        header.portalCount = uint32_t(design.portals.size());
+        Append(out, portals);
+
+        header.size = uint32_t(out.size());
+        std::memcpy(out.data(), &header, sizeof(header));
+
+        auto aside = path + ".new";
+        {
+            std::ofstream file(aside, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(out.data()), std::streamsize(out.size()));
+
+            if (!file.flush())
+            {
+                throw std::runtime_error("Could not write " + aside);
+            }
+        }
+
+        if (std::rename(aside.c_str(), path.c_str()) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "rename " + aside);
+        }
+    }
+
+private:
+    static constexpr const char* Magic = "SNKL";
+
+    struct Header
+    {
+        char magic[4];
+        uint16_t version;
+        uint16_t width;
+        uint16_t height;
+        uint16_t rowWords;
+        uint32_t size;
+        uint32_t walls;
+        uint32_t free;
+        uint32_t freeCount;
+        uint32_t zones;
+        uint32_t zoneCount;
+        uint32_t zoneCells;
+        uint32_t zoneCellCount;
+        uint32_t portals;
+        uint32_t portalCount;
+        uint8_t reserved[12];
+    };
+
+    static_assert(sizeof(Header) == 64, "The header is one 64-byte section");
+
+    struct Zone
+    {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    const uint8_t* _data;
+    size_t _size;
+
+    const Header& GetHeader() const
+    {
+        return *reinterpret_cast<const Header*>(_data);
+    }
+
+    const uint16_t* Cells(uint32_t offset) const
+    {
+        return reinterpret_cast<const uint16_t*>(_data + offset);
+    }
+
+    const Zone* Zones() const
+    {
+        return reinterpret_cast<const Zone*>(_data + GetHeader().zones);
+    }
+
+    Cell Unpack(uint16_t index) const
+    {
+        return std::make_pair(index % Width(), index / Width());
+    }
+
+    // Everything the accessors reach has to lie inside the file, and every cell
+    // inside the level, so a damaged file is refused here rather than read past
+    void Validate() const
+    {
+        auto& header = GetHeader();
+
+        if (std::memcmp(header.magic, Magic, sizeof(header.magic)) != 0)
+        {
+            throw std::runtime_error("is not a level");
+        }
+
+        if (header.version != Version)
+        {
+            throw std::runtime_error("is version " + std::to_string(header.version));
+        }
+
+        size_t cells = size_t(header.width) * header.height;
+
+        if (header.width < 3 || header.height < 3 || cells > UINT16_MAX || header.rowWords != header.width / 64 + 1 ||
+            header.size != _size)
+        {
+            throw std::runtime_error("has a damaged header");
+        }
+
+        Check(header.walls, size_t(header.rowWords) * (header.height + 2) * sizeof(uint64_t));
+        Check(header.free, size_t(header.freeCount) * sizeof(uint16_t));
+        Check(header.zones, size_t(header.zoneCount) * sizeof(Zone));
+        Check(header.zoneCells, size_t(header.zoneCellCount) * sizeof(uint16_t));
+        Check(header.portals, size_t(header.portalCount) * 2 * sizeof(uint16_t));
+
+        for (int x = 0; x < header.width; x++)
+        {
+            if (!IsWall(x, 0) || !IsWall(x, header.height - 1))
+            {
+                throw std::runtime_error("is not walled all round");
+            }
+        }
+
+        for (int y = 0; y < header.height; y++)
+        {
+            if (!IsWall(0, y) || !IsWall(header.width - 1, y))
+            {
+                throw std::runtime_error("is not walled all round");
+            }
+        }
+
+        auto floor = [&](const uint16_t* at, size_t count)
+        {
+            for (size_t n = 0; n < count; n++)
+            {
+                if (at[n] >= cells || IsWall(at[n] % header.width, at[n] / header.width))
+                {
+                    throw std::runtime_error("has a cell that is not floor");
+                }
+            }
+        };
+
+        floor(Cells(header.free), header.freeCount);
+        floor(Cells(header.zoneCells), header.zoneCellCount);
+        floor(Cells(header.portals), size_t(header.portalCount) * 2);
+
+        for (size_t n = 0; n < header.zoneCount; n++)
+        {
+            if (Zones()[n].first > header.zoneCellCount || Zones()[n].count > header.zoneCellCount - Zones()[n].first)
+            {
+                throw std::runtime_error("has a zone beyond its cells");
+            }
+        }
+    }
+
+    void Check(uint32_t offset, size_t length) const
+    {
+        if (offset % 64 != 0 || offset < sizeof(Header) || offset > _size || length > _size - offset)
+        {
+            throw std::runtime_error("has a section beyond its end");
+        }
+    }
+
+    static uint32_t Section(std::vector<uint8_t>& out)
+    {
+        out.resize((out.size() + 63) / 64 * 64);
+        return uint32_t(out.size());
+    }
+
+    template <typename T>
+    static void Append(std::vector<uint8_t>& out, const std::vector<T>& values)
+    {
+        auto at = out.size();
+        out.resize(at + values.size() * sizeof(T));
+
+        if (!values.empty())
+        {
+            std::memcpy(out.data() + at, values.data(), values.size() * sizeof(T));
+        }
+    }
+};
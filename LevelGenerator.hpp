@@ -0,0 +1,197 @@
+#pragma once
+
+#include "Bitboard.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Wall layouts for endless play, one per seed. A candidate scatters straight walls
+// over the board, keeping clear the lane where the snake starts, and is kept only
+// if its floor is one connected region with enough room. Candidates are tried on
+// a pool of workers, in order of a counter, and the first that passes wins, so a
+// seed always gives the same level however many workers there are.
+//
+// Prepare() generates on a thread of its own while the current round is played,
+// and Take() hands the level over, waiting only if it is not done yet.
+template <int width, int height>
+class LevelGenerator
+{
+public:
+    // After this many candidates fail the board is left bare
+    static constexpr uint64_t MaxCandidates = 4096;
+
+    explicit LevelGenerator(double minFree = 0.75, size_t workers = std::max(1u, std::thread::hardware_concurrency())) :
+        _minFree(minFree),
+        _pool(workers),
+        _next(Border()),
+        _ready(true)
+    {}
+
+    ~LevelGenerator()
+    {
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+    }
+
+    LevelGenerator(const LevelGenerator&) = delete;
+    LevelGenerator& operator=(const LevelGenerator&) = delete;
+
+    // Starts on the level for seed in the background
+    void Prepare(uint64_t seed)
+    {
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+
+        _ready.store(false, std::memory_order_relaxed);
+        _thread = std::thread([this, seed]()
+        {
+            _next = Generate(seed);
+            _ready.store(true, std::memory_order_release);
+        });
+    }
+
+    bool Ready() const
+    {
+        return _ready.load(std::memory_order_acquire);
+    }
+
+    // The walls of the level Prepare() started on
+    Bitboard<width, height> Take()
+    {
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+
+        return _next;
+    }
+
+    // Fills walls with one candidate and returns true if it can be played
+    bool Candidate(uint64_t seed, Bitboard<width, height>& walls) const
+    {
+        walls = Border();
+
+        for (int n = 0; n < width * height / 160; n++)
+        {
+            auto r = Next(seed);
+            int x = 1 + int(r % (width - 2));
+            int y = 1 + int(r / (width - 2) % (height - 2));
+            bool across = r >> 40 & 1;
+            int length = 3 + int(r >> 48) % std::max(1, std::min(width, height) / 3);
+
+            for (int i = 0; i < length && x < width - 1 && y < height - 1; i++)
+            {
+                if (!InStartLane(x, y))
+                {
+                    walls.Set(std::make_pair(x, y));
+                }
+
+                across ? x++ : y++;
+            }
+        }
+
+        Bitboard<width, height> open;
+        for (int y = 1; y < height - 1; y++)
+        {
+            for (int x = 1; x < width - 1; x++)
+            {
+                open.Assign(std::make_pair(x, y), !walls.Test(std::make_pair(x, y)));
+            }
+        }
+
+        auto free = open.Count();
+        if (free < size_t(_minFree * (width - 2) * (height - 2)))
+        {
+            return false;
+        }
+
+        Bitboard<width, height> start;
+        start.Set(std::make_pair(width / 2, height / 2));
+        return (Bitboard<width, height>::Fill(start, open) & open).Count() == free;
+    }
+
+private:
+    double _minFree;
+    WorkerPool _pool;
+    std::thread _thread;
+    Bitboard<width, height> _next;
+    std::atomic<bool> _ready;
+
+    Bitboard<width, height> Generate(uint64_t seed)
+    {
+        std::atomic<uint64_t> next(0);
+        std::atomic<uint64_t> best(MaxCandidates);
+        std::vector<uint64_t> found(_pool.Size(), MaxCandidates);
+        std::vector<Bitboard<width, height>> levels(_pool.Size());
+
+        _pool.Run([&](size_t worker)
+        {
+            Bitboard<width, height> walls;
+
+            // Every candidate below the best found so far is tried, so the best is
+            // the first that passes
+            for (auto k = next.fetch_add(1); k < best.load(); k = next.fetch_add(1))
+            {
+                if (Candidate(Mix(seed, k), walls))
+                {
+                    found[worker] = k;
+                    levels[worker] = walls;
+
+                    for (auto b = best.load(); k < b && !best.compare_exchange_weak(b, k);)
+                    {
+                    }
+
+                    return;
+                }
+            }
+        });
+
+        auto winner = std::min_element(found.begin(), found.end());
+        return *winner < MaxCandidates ? levels[size_t(winner - found.begin())] : Border();
+    }
+
+    static Bitboard<width, height> Border()
+    {
+        Bitboard<width, height> walls;
+
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                walls.Assign(std::make_pair(x, y), x == 0 || x == width - 1 || y == 0 || y == height - 1);
+            }
+        }
+
+        return walls;
+    }
+
+    // Where Game puts the snake, heading north, with room to turn ahead of it
+    static bool InStartLane(int x, int y)
+    {
+        return std::abs(x - width / 2) <= 1 && y >= height / 2 - 8 && y <= height / 2 + 5;
+    }
+
+    // splitmix64
+    static uint64_t Next(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    static uint64_t Mix(uint64_t seed, uint64_t k)
+    {
+        uint64_t state = seed ^ (k * 0xD1B54A32D192ED03ull);
+        return Next(state);
+    }
+};
@@ -0,0 +1,310 @@
+#pragma once
+
+#include "Game.hpp"
+#include "TranspositionTable.hpp"
+#include "WorkerPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Monte Carlo tree search over our own moves. Where obstacles appear is left to
+// chance: each iteration copies the game, reseeds its RNG and replays the moves
+// down the tree, so nodes average over the futures they lead to. All workers
+// share one tree. Its statistics are atomics, and a visit is counted on the way
+// down, which steers the other workers away from paths already being explored.
+// Rollout results are shared through a transposition table. A position reached
+// again at the same depth reuses the average of the results already stored for it.
+template <int width, int height>
+class Mcts
+{
+    static_assert(std::is_trivially_copyable<Game<width, height>>::value, "Snapshots must copy without allocating");
+
+public:
+    Mcts(WorkerPool& pool,
+         std::chrono::milliseconds budget = std::chrono::milliseconds(40),
+         size_t nodes = 1 << 20,
+         int horizon = 60) :
+        _pool(pool),
+        _budget(budget),
+        _nodes(new Node[nodes]),
+        _capacity(nodes),
+        _used(0),
+        _horizon(horizon)
+    {}
+
+    Direction Plan(const Game<width, height>& game)
+    {
+        auto deadline = std::chrono::steady_clock::now() + _budget;
+
+        _root = game;
+        _table.Clear();
+        _used.store(1, std::memory_order_relaxed);
+        Reset(_nodes[0], game.GetDirection());
+        Expand(_nodes[0], _root);
+
+        uint64_t seed = uint64_t(deadline.time_since_epoch().count());
+
+        _pool.Run([this, deadline, seed](size_t worker)
+        {
+            Game<width, height> state;
+            std::vector<uint32_t> path;
+            path.reserve(size_t(_horizon) + 1);
+            uint64_t random = seed ^ (uint64_t(worker + 1) * 0x9E3779B97F4A7C15ull);
+
+            while (std::chrono::steady_clock::now() < deadline)
+            {
+                state = _root;
+                state.Seed(NextRandom(random));
+                Iterate(state, path, random);
+            }
+        });
+
+        auto& root = _nodes[0];
+        auto best = game.GetDirection();
+        uint32_t bestVisits = 0;
+
+        for (uint8_t n = 0; n < root.childCount; n++)
+        {
+            auto& child = _nodes[root.firstChild.load(std::memory_order_relaxed) + n];
+            auto visits = child.visits.load(std::memory_order_relaxed);
+
+            if (visits > bestVisits)
+            {
+                best = child.move;
+                bestVisits = visits;
+            }
+        }
+
+        return best;
+    }
+
+private:
+    static constexpr uint8_t Leaf = 0;
+    static constexpr uint8_t Expanding = 1;
+    static constexpr uint8_t Expanded = 2;
+
+    // Rewards are summed as fixed point so one fetch_add updates them
+    static constexpr double Scale = 65536.0;
+
+    // Rollouts a position needs before its stored average replaces new ones
+    static constexpr uint64_t Samples = 8;
+
+    struct Node
+    {
+        std::atomic<uint32_t> visits;
+        std::atomic<uint64_t> value;
+        std::atomic<uint32_t> firstChild;
+        std::atomic<uint8_t> state;
+        uint8_t childCount;
+        Direction move;
+    };
+
+    WorkerPool& _pool;
+    std::chrono::milliseconds _budget;
+    std::unique_ptr<Node[]> _nodes;
+    size_t _capacity;
+    std::atomic<size_t> _used;
+    int _horizon;
+    Game<width, height> _root;
+    TranspositionTable _table;
+
+    static uint64_t NextRandom(uint64_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    static constexpr Coordinates Neighbour(const Coordinates& c, Direction direction)
+    {
+        switch (direction)
+        {
+            case Direction::North: return {c.first, c.second - 1};
+            case Direction::East:  return {c.first + 1, c.second};
+            case Direction::South: return {c.first, c.second + 1};
+            case Direction::West:  return {c.first - 1, c.second};
+        }
+
+        return c;
+    }
+
+    static void Reset(Node& node, Direction move)
+    {
+        node.visits.store(0, std::memory_order_relaxed);
+        node.value.store(0, std::memory_order_relaxed);
+        node.firstChild.store(0, std::memory_order_relaxed);
+        node.childCount = 0;
+        node.move = move;
+        node.state.store(Leaf, std::memory_order_relaxed);
+    }
+
+    // Children only for moves that are free in this copy of the game
+    void Expand(Node& node, const Game<width, height>& state)
+    {
+        Direction moves[4];
+        uint8_t count = 0;
+
+        for (auto direction : {Direction::North, Direction::East, Direction::South, Direction::West})
+        {
+            if (!state.IsBlocked(Neighbour(state.Head(), direction)))
+            {
+                moves[count++] = direction;
+            }
+        }
+
+        auto first = _used.fetch_add(count, std::memory_order_relaxed);
+
+        if (first + count > _capacity)
+        {
+            // Out of nodes: the tree stops growing here and only rollouts continue
+            count = 0;
+        }
+
+        for (uint8_t n = 0; n < count; n++)
+        {
+            Reset(_nodes[first + n], moves[n]);
+        }
+
+        node.firstChild.store(uint32_t(first), std::memory_order_relaxed);
+        node.childCount = count;
+        node.state.store(Expanded, std::memory_order_release);
+    }
+
+    uint32_t Select(const Node& node) const
+    {
+        auto first = node.firstChild.load(std::memory_order_relaxed);
+        auto parentVisits = std::log(double(node.visits.load(std::memory_order_relaxed)) + 1.0);
+        uint32_t best = first;
+        double bestScore = -1.0;
+
+        for (uint8_t n = 0; n < node.childCount; n++)
+        {
+            auto& child = _nodes[first + n];
+            auto visits = child.visits.load(std::memory_order_relaxed);
+
+            if (visits == 0)
+            {
+                return first + n;
+            }
+
+            auto mean = double(child.value.load(std::memory_order_relaxed)) / Scale / visits;
+            auto score = mean + 1.4 * std::sqrt(parentVisits / visits);
+
+            if (score > bestScore)
+            {
+                best = first + n;
+                bestScore = score;
+            }
+        }
+
+        return best;
+    }
+
+    void Iterate(Game<width, height>& state, std::vector<uint32_t>& path, uint64_t& random)
+    {
+        path.clear();
+        path.push_back(0);
+        _nodes[0].visits.fetch_add(1, std::memory_order_relaxed);
+
+        auto score = state.Score();
+        int ticks = 0;
+        bool alive = true;
+
+        while (alive && ticks < _horizon)
+        {
+            auto& node = _nodes[path.back()];
+
+            if (node.state.load(std::memory_order_acquire) != Expanded)
+            {
+                // Grow the tree by one node per iteration; whoever loses the race rolls out
+                uint8_t leaf = Leaf;
+
+                if (node.visits.load(std::memory_order_relaxed) < 2 ||
+                    !node.state.compare_exchange_strong(leaf, Expanding, std::memory_order_acquire))
+                {
+                    break;
+                }
+
+                Expand(node, state);
+            }
+
+            if (node.childCount == 0)
+            {
+                break;
+            }
+
+            auto child = Select(node);
+            _nodes[child].visits.fetch_add(1, std::memory_order_relaxed);
+            path.push_back(child);
+
+            state.SetDirection(_nodes[child].move);
+            alive = state.TryTick();
+            ticks++;
+        }
+
+        // The reward depends on the position, the depth and whether we have eaten yet
+        bool ate = state.Score() > score;
+        auto key = state.Hash() ^ ((uint64_t(ticks) << 1 | uint64_t(ate)) * 0x9E3779B97F4A7C15ull);
+        uint64_t stored = 0;
+        bool leaf = alive && ticks < _horizon;
+
+        if (leaf && _table.Probe(key, stored) && (stored >> 32) >= Samples)
+        {
+            Backup(path, double(uint32_t(stored)) / UINT32_MAX);
+            return;
+        }
+
+        // Rollout: wander randomly but never into a cell that is already blocked
+        while (alive && ticks < _horizon)
+        {
+            Direction moves[4];
+            int count = 0;
+
+            for (auto direction : {Direction::North, Direction::East, Direction::South, Direction::West})
+            {
+                if (!state.IsBlocked(Neighbour(state.Head(), direction)))
+                {
+                    moves[count++] = direction;
+                }
+            }
+
+            if (count > 0)
+            {
+                state.SetDirection(moves[NextRandom(random) % count]);
+            }
+
+            alive = state.TryTick();
+            ticks++;
+        }
+
+        auto survived = alive ? 1.0 : 0.5 * ticks / _horizon;
+        auto reward = 0.7 * survived + (state.Score() > score ? 0.3 : 0.0);
+
+        if (leaf)
+        {
+            // Racing writers may lose a sample, which only costs another rollout later
+            auto count = stored >> 32;
+            auto mean = double(uint32_t(stored)) / UINT32_MAX;
+            mean += (reward - mean) / double(count + 1);
+            _table.Store(key, (count + 1) << 32 | uint64_t(mean * UINT32_MAX));
+        }
+
+        Backup(path, reward);
+    }
+
+    void Backup(const std::vector<uint32_t>& path, double reward)
+    {
+        auto value = uint64_t(reward * Scale);
+
+        for (auto n : path)
+        {
+            _nodes[n].value.fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+};
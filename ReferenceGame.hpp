@@ -0,0 +1,254 @@
+#pragma once
+
+#include "Game.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// The rules of Game written the plain way, as Snake first played them: the body
+// and the obstacles are lists, and every collision is a search through them. It
+// is slow and meant to stay that way, so there is something obvious to check the
+// fast Game against.
+template <int width, int height>
+class ReferenceGame
+{
+public:
+    ReferenceGame() :
+        _currentDirection(Direction::North),
+        _random(0),
+        _tickCount(0),
+        _score(0),
+        _growth(0)
+    {
+        CreateInitialSnake();
+    }
+
+    void Seed(uint64_t seed)
+    {
+        _random = seed;
+    }
+
+    Direction GetDirection() const
+    {
+        return _currentDirection;
+    }
+
+    void SetDirection(Direction direction)
+    {
+        _currentDirection = direction;
+    }
+
+    size_t Length() const
+    {
+        return _snake.size();
+    }
+
+    Coordinates Body(size_t n) const
+    {
+        return _snake.at(n);
+    }
+
+    // The good obstacles, then the bad ones
+    size_t ObstacleCount() const
+    {
+        return _goodObstacles.size() + _badObstacles.size();
+    }
+
+    Coordinates Obstacle(size_t n) const
+    {
+        return n < _goodObstacles.size() ? _goodObstacles[n] : _badObstacles.at(n - _goodObstacles.size());
+    }
+
+    bool IsBad(const Coordinates& c) const
+    {
+        return Contains(_badObstacles, c);
+    }
+
+    size_t TickCount() const
+    {
+        return _tickCount;
+    }
+
+    size_t Score() const
+    {
+        return _score;
+    }
+
+    size_t PendingGrowth() const
+    {
+        return _growth;
+    }
+
+    bool TryTick()
+    {
+        auto entropy = size_t(NextRandom());
+
+        FollowTheSnakeHead();
+
+        if (!MoveTheSnakeHead(entropy))
+        {
+            return false;
+        }
+
+        if (_tickCount % 10 == 0)
+        {
+            AppendTheSnake(1);
+        }
+
+        if (_tickCount % 30 == 0)
+        {
+            CreateObstacle(entropy);
+        }
+
+        _tickCount++;
+        return true;
+    }
+
+private:
+    std::vector<Coordinates> _snake;
+    std::vector<Coordinates> _goodObstacles;
+    std::vector<Coordinates> _badObstacles;
+    Direction _currentDirection;
+    uint64_t _random;
+    size_t _tickCount;
+    size_t _score;
+    size_t _growth;
+
+    // splitmix64, as Game draws it
+    uint64_t NextRandom()
+    {
+        uint64_t z = (_random += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    static bool IsBorder(int x, int y)
+    {
+        if (x == 0)
+        {
+            return true;
+        }
+        else if (x == width - 1)
+        {
+            return true;
+        }
+        else if (y == 0)
+        {
+            return true;
+        }
+        else if (y == height - 1)
+        {
+            return true;
+        }
+
+        return false;
+    }
+
+    static bool Contains(const std::vector<Coordinates>& cells, const Coordinates& c, size_t from = 0)
+    {
+        for (size_t n = from; n < cells.size(); n++)
+        {
+            if (cells[n] == c)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void CreateInitialSnake()
+    {
+        _snake.push_back(std::make_pair(width / 2, height / 2));
+        _snake.push_back(std::make_pair(_snake.back().first, _snake.back().second + 1));
+        _snake.push_back(std::make_pair(_snake.back().first, _snake.back().second + 1));
+        _snake.push_back(std::make_pair(_snake.back().first, _snake.back().second + 1));
+        _snake.push_back(std::make_pair(_snake.back().first, _snake.back().second + 1));
+    }
+
+    void AppendTheSnake(int x)
+    {
+        _growth += size_t(x);
+    }
+
+    void FollowTheSnakeHead()
+    {
+        if (_growth > 0)
+        {
+            _growth--;
+        }
+        else
+        {
+            _snake.pop_back();
+        }
+    }
+
+    bool MoveTheSnakeHead(size_t entropy)
+    {
+        auto head = _snake.front();
+
+        switch (_currentDirection)
+        {
+            case Direction::North: head.second--; break;
+            case Direction::East:  head.first++; break;
+            case Direction::South: head.second++; break;
+            case Direction::West:  head.first--; break;
+        }
+
+        _snake.insert(_snake.begin(), head);
+        return CheckCollosion(entropy);
+    }
+
+    bool CheckCollosion(size_t entropy)
+    {
+        auto head = _snake.front();
+
+        if (IsBorder(head.first, head.second) || Contains(_snake, head, 1) || Contains(_badObstacles, head))
+        {
+            return false;
+        }
+
+        if (Contains(_goodObstacles, head))
+        {
+            _goodObstacles.clear();
+            _badObstacles.clear();
+            _score++;
+            AppendTheSnake(5);
+            CreateObstacle(entropy);
+        }
+
+        return true;
+    }
+
+    // A taken cell passes the obstacle on to the next cell, row by row, wrapping
+    // from the last cell to the first
+    void CreateObstacle(size_t entropy)
+    {
+        auto c = std::make_pair(int(uint64_t(entropy) % width), int((uint64_t(entropy) >> 32) % height));
+
+        for (int n = 0; IsBorder(c.first, c.second) || Contains(_snake, c) ||
+                        Contains(_goodObstacles, c) || Contains(_badObstacles, c); n++)
+        {
+            if (n == width * height)
+            {
+                return;
+            }
+
+            if (++c.first == width)
+            {
+                c.first = 0;
+                c.second = (c.second + 1) % height;
+            }
+        }
+
+        if ((uint64_t(entropy) >> 16) % 3 == 0)
+        {
+            _goodObstacles.push_back(c);
+        }
+        else
+        {
+            _badObstacles.push_back(c);
+        }
+    }
+};
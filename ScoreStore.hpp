@@ -0,0 +1,526 @@
+#pragma once
+
+#include "Game.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+// High scores and the record of every run, kept in an append-only log. Submit()
+// only writes to a lock-free queue, so the game never waits on the disk. A writer
+// thread drains the queue, appends what it found in one write and syncs it.
+//
+// Each record carries a CRC-32C, so a log cut short by a crash is noticed on the
+// next open: the file is mapped, records are checked in one pass up to the first
+// that does not match, and the log is truncated there. The same pass rebuilds the
+// best runs, which are kept in memory for Top().
+//
+// The log starts with a 16-byte header, "SNKSCORE", a u32 version and a u32 record
+// size, followed by records of a u32 CRC of the run, four zero bytes and the Run.
+class ScoreStore
+{
+public:
+    static constexpr uint32_t Version = 1;
+
+    enum class Death : uint8_t
+    {
+        Wall,
+        Body,
+        Bad,
+        // The run ended without a collision
+        Quit
+    };
+
+    struct Run
+    {
+        // Milliseconds since the epoch when the run ended
+        uint64_t time;
+        uint64_t seed;
+        uint32_t score;
+        uint32_t length;
+        uint32_t ticks;
+        Death death;
+        uint8_t reserved[3];
+    };
+
+    static_assert(sizeof(Run) == 32, "Runs are stored as they are laid out");
+
+    // How a game that has just stopped went. alive is what its last TryTick() returned
+    template <int width, int height>
+    static Run Finish(const Game<width, height>& game, bool alive, uint64_t seed)
+    {
+        Run run{};
+        run.time = uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        run.seed = seed;
+        run.score = uint32_t(game.Score());
+        run.length = uint32_t(game.Length());
+        run.ticks = uint32_t(game.TickCount());
+        run.death = alive ? Death::Quit : game.IsWall(game.Head()) ? Death::Wall : game.IsBad(game.Head()) ? Death::Bad : Death::Body;
+        return run;
+    }
+
+    explicit ScoreStore(const std::string& path, size_t keep = 100) :
+        _keep(keep),
+        _slots(new Slot[QueueSize]),
+        _tail(0),
+        _head(0),
+        _submitted(0),
+        _written(0),
+        _lost(0),
+        _failedWrites(0),
+        _dropped(0),
+        _runs(0),
+        _stop(false)
+    {
+        for (size_t n = 0; n < QueueSize; n++)
+        {
+            _slots[n].sequence.store(n, std::memory_order_relaxed);
+        }
+
+        _fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        Check(_fd, "open");
+
+        try
+        {
+            Recover(path);
+        }
+        catch (...)
+        {
+            close(_fd);
+            throw;
+        }
+
+        _writer = std::thread([this]() { Write(); });
+    }
+
+    // Writes out everything submitted before returning
+    ~ScoreStore()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _wake.notify_one();
+        _writer.join();
+        close(_fd);
+    }
+
+    ScoreStore(const ScoreStore&) = delete;
+    ScoreStore& operator=(const ScoreStore&) = delete;
+
+    // Never blocks. Returns false, and drops the run, if the writer has fallen a
+    // whole queue behind
+    bool Submit(const Run& run)
+    {
+        auto position = _tail.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            auto& slot = _slots[position & (QueueSize - 1)];
+            auto sequence = slot.sequence.load(std::memory_order_acquire);
+            auto lag = intptr_t(sequence) - intptr_t(position);
+
+            if (lag == 0 && _tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                slot.run = run;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                _submitted.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            if (lag < 0)
+            {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            if (lag > 0)
+            {
+                position = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Waits until every run submitted so far has been written out. Returns false if
+    // a write failed meanwhile, so some of those runs are not on disk
+    bool Flush()
+    {
+        auto target = _submitted.load(std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(_mutex);
+        auto lost = _lost;
+        _flush = true;
+        _wake.notify_one();
+        _synced.wait(lock, [this, target]() { return _written + _lost >= target; });
+        return _lost == lost;
+    }
+
+    // The best n runs on disk, by score, then length, then whoever got there first
+    std::vector<Run> Top(size_t n) const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<Run> top;
+
+        for (auto it = _best.begin(); it != _best.end() && top.size() < n; ++it)
+        {
+            top.push_back(*it);
+        }
+
+        return top;
+    }
+
+    // Runs on disk
+    uint64_t Runs() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _runs;
+    }
+
+    // Runs turned away because the queue was full
+    uint64_t Dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    // Runs taken from the queue that could not be written and synced
+    uint64_t Lost() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _lost;
+    }
+
+    // Batches whose write or sync failed
+    uint64_t FailedWrites() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _failedWrites;
+    }
+
+private:
+    static constexpr size_t QueueSize = 1024;
+    static constexpr char Magic[8] = {'S', 'N', 'K', 'S', 'C', 'O', 'R', 'E'};
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+    };
+
+    struct Record
+    {
+        uint32_t crc;
+        uint32_t reserved;
+        Run run;
+    };
+
+    static_assert(sizeof(Header) == 16 && sizeof(Record) == 40, "Records are stored as they are laid out");
+
+    // A bounded queue for any number of producers and one consumer: each slot's
+    // sequence says whose turn it is to use it
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        Run run;
+    };
+
+    struct Better
+    {
+        bool operator()(const Run& a, const Run& b) const
+        {
+            if (a.score != b.score)
+            {
+                return a.score > b.score;
+            }
+
+            if (a.length != b.length)
+            {
+                return a.length > b.length;
+            }
+
+            return a.time < b.time;
+        }
+    };
+
+    size_t _keep;
+    int _fd;
+    off_t _end;
+    std::unique_ptr<Slot[]> _slots;
+    alignas(64) std::atomic<size_t> _tail;
+    alignas(64) size_t _head;
+    std::atomic<uint64_t> _submitted;
+    // Runs synced, and runs lost with a batch that failed
+    uint64_t _written;
+    uint64_t _lost;
+    uint64_t _failedWrites;
+    std::atomic<uint64_t> _dropped;
+    uint64_t _runs;
+    std::multiset<Run, Better> _best;
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _synced;
+    bool _flush = false;
+    bool _stop;
+    std::thread _writer;
+
+    // Checks the records from the start, keeps the ones before the first bad one,
+    // and cuts the log there
+    void Recover(const std::string& path)
+    {
+        struct stat info;
+        Check(fstat(_fd, &info), "fstat");
+        auto size = size_t(info.st_size);
+
+        // Only an empty file is new; anything shorter than a header is someone else's
+        if (size > 0 && size < sizeof(Header))
+        {
+            throw std::runtime_error("Score log " + path + " is too short to be a log");
+        }
+
+        if (size == 0)
+        {
+            Header header{};
+            std::memcpy(header.magic, Magic, sizeof(Magic));
+            header.version = Version;
+            header.recordSize = sizeof(Record);
+
+            Check(pwrite(_fd, &header, sizeof(header), 0) == sizeof(header) ? 0 : -1, "pwrite");
+            Check(fdatasync(_fd), "fdatasync");
+            _end = sizeof(header);
+            return;
+        }
+
+        auto memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, _fd, 0);
+        if (memory == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+
+        auto* data = static_cast<const uint8_t*>(memory);
+        Header header;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version ||
+            header.recordSize != sizeof(Record))
+        {
+            munmap(memory, size);
+            throw std::runtime_error("Score log " + path + " is not a version " + std::to_string(Version) + " log");
+        }
+
+        size_t at = sizeof(Header);
+
+        for (; at + sizeof(Record) <= size; at += sizeof(Record))
+        {
+            Record record;
+            std::memcpy(&record, data + at, sizeof(record));
+
+            if (record.reserved != 0 || record.crc != Crc(record.run))
+            {
+                break;
+            }
+
+            Index(record.run);
+        }
+
+        munmap(memory, size);
+
+        if (at != size)
+        {
+            Check(ftruncate(_fd, off_t(at)), "ftruncate");
+            Check(fdatasync(_fd), "fdatasync");
+        }
+
+        _end = off_t(at);
+    }
+
+    void Index(const Run& run)
+    {
+        _runs++;
+
+        if (_keep == 0)
+        {
+            return;
+        }
+
+        if (_best.size() < _keep)
+        {
+            _best.insert(run);
+        }
+        else if (Better()(run, *std::prev(_best.end())))
+        {
+            _best.erase(std::prev(_best.end()));
+            _best.insert(run);
+        }
+    }
+
+    bool Pop(Run& run)
+    {
+        auto& slot = _slots[_head & (QueueSize - 1)];
+
+        if (slot.sequence.load(std::memory_order_acquire) != _head + 1)
+        {
+            return false;
+        }
+
+        run = slot.run;
+        slot.sequence.store(_head + QueueSize, std::memory_order_release);
+        _head++;
+        return true;
+    }
+
+    // Wakes every so often, or when asked to flush or stop, and writes whatever has
+    // been submitted in one go
+    void Write()
+    {
+        std::vector<Record> batch;
+        std::vector<Run> runs;
+
+        while (true)
+        {
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait_for(lock, std::chrono::milliseconds(100), [this]() { return _stop || _flush; });
+                _flush = false;
+                stop = _stop;
+            }
+
+            batch.clear();
+            runs.clear();
+
+            for (Run run; Pop(run);)
+            {
+                Record record{Crc(run), 0, run};
+                batch.push_back(record);
+                runs.push_back(run);
+            }
+
+            bool failed = false;
+
+            if (!batch.empty())
+            {
+                auto bytes = batch.size() * sizeof(Record);
+                auto written = pwrite(_fd, batch.data(), bytes, _end);
+
+                // Whatever part of a failed batch reached the file is cut off, so
+                // the next batch cannot leave some of it behind to be recovered.
+                // Its runs stay out of the index since they are not safely on disk
+                if (written == ssize_t(bytes) && fdatasync(_fd) == 0)
+                {
+                    _end += off_t(bytes);
+                }
+                else
+                {
+                    failed = true;
+                    auto cut = ftruncate(_fd, _end);
+                    (void)cut;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+
+                if (failed)
+                {
+                    _lost += batch.size();
+                    _failedWrites++;
+                }
+                else
+                {
+                    for (auto& run : runs)
+                    {
+                        Index(run);
+                    }
+
+                    _written += batch.size();
+                }
+            }
+
+            _synced.notify_all();
+
+            if (stop && _head == _tail.load(std::memory_order_acquire))
+            {
+                return;
+            }
+        }
+    }
+
+    static uint32_t Crc(const Run& run)
+    {
+        uint8_t bytes[sizeof(Run)];
+        std::memcpy(bytes, &run, sizeof(run));
+        uint32_t crc = ~0u;
+
+#if defined(__SSE4_2__)
+        for (size_t n = 0; n < sizeof(bytes); n += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + n, sizeof(word));
+            crc = uint32_t(_mm_crc32_u64(crc, word));
+        }
+#else
+        for (auto byte : bytes)
+        {
+            crc = CrcTable()[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+        }
+#endif
+
+        return ~crc;
+    }
+
+    // CRC-32C, the polynomial SSE 4.2 computes, reflected
+    static const std::array<uint32_t, 256>& CrcTable()
+    {
+        static const auto table = []()
+        {
+            std::array<uint32_t, 256> table{};
+
+            for (uint32_t n = 0; n < 256; n++)
+            {
+                uint32_t crc = n;
+
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    crc = crc & 1 ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+                }
+
+                table[n] = crc;
+            }
+
+            return table;
+        }();
+
+        return table;
+    }
+
+    static void Check(int result, const char* what)
+    {
+        if (result < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+    }
+};
@@ -0,0 +1,502 @@
+#pragma once
+
+#include "DeltaStream.hpp"
+#include "Game.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Headless games for local clients over a UNIX stream socket, one game per
+// connection. Sessions are sharded over threads that each run an epoll loop, all
+// waiting on the same listening socket, so a connection stays on the thread that
+// accepted it and shards never share state. Every shard ticks its sessions from
+// its own timer and sends each client only what the tick changed.
+//
+// From the client, one byte each:
+//   0-3  turn North, East, South or West on the next tick
+//   'R'  start a new game
+// From the server, 'H' u16 width, u16 height once the connection is accepted, then
+// a DeltaStream that starts with a keyframe, and again with every new game.
+template <int width, int height>
+class Server
+{
+public:
+    Server(const std::string& path,
+           size_t shards = std::max(1u, std::thread::hardware_concurrency()),
+           std::chrono::milliseconds tick = std::chrono::milliseconds(50)) :
+        _path(path),
+        _tick(tick),
+        _shards(shards),
+        _sessions(0)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            throw std::invalid_argument("Socket path is too long");
+        }
+
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        _listener = Check(socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0), "socket");
+        unlink(path.c_str());
+        Check(bind(_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)), "bind");
+        Check(listen(_listener, SOMAXCONN), "listen");
+        _stop = Check(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC), "eventfd");
+    }
+
+    ~Server()
+    {
+        close(_stop);
+        close(_listener);
+        unlink(_path.c_str());
+    }
+
+    // Serves until Stop() is called. A shard that fails stops the others, and once
+    // they are all done the first failure is thrown from here
+    void Run()
+    {
+        std::vector<std::thread> threads;
+        std::vector<std::exception_ptr> errors(_shards);
+
+        auto join = [&threads]()
+        {
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        };
+
+        try
+        {
+            for (size_t n = 0; n < _shards; n++)
+            {
+                threads.emplace_back([this, &errors, n]()
+                {
+                    try
+                    {
+                        Shard(*this).Run();
+                    }
+                    catch (...)
+                    {
+                        errors[n] = std::current_exception();
+                        Stop();
+                    }
+                });
+            }
+        }
+        catch (...)
+        {
+            Stop();
+            join();
+            throw;
+        }
+
+        join();
+
+        for (auto& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    // Safe to call from any thread and from a signal handler
+    void Stop()
+    {
+        uint64_t one = 1;
+        auto written = write(_stop, &one, sizeof(one));
+        (void)written;
+    }
+
+    size_t Sessions() const
+    {
+        return _sessions.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Turns beyond this are dropped until the game catches up, as in Snake
+    static constexpr size_t MaxTurns = 3;
+
+    // A client that lets this much output pile up is disconnected
+    static constexpr size_t MaxPending = 64 * 1024;
+
+    struct Session
+    {
+        int socket;
+        Game<width, height> game;
+        Direction turns[MaxTurns];
+        uint8_t turnCount;
+        bool alive;
+        bool blocked;
+        DeltaStream::Encoder<width, height> stream;
+        std::vector<uint8_t> pending;
+    };
+
+    class Shard
+    {
+    public:
+        explicit Shard(Server& server) :
+            _server(server),
+            _epoll(Check(epoll_create1(EPOLL_CLOEXEC), "epoll_create1")),
+            _timer(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+            _random(uint64_t(std::chrono::steady_clock::now().time_since_epoch().count()) ^ uint64_t(_epoll))
+        {
+            try
+            {
+                Check(_timer, "timerfd_create");
+
+                itimerspec period{};
+                period.it_interval.tv_sec = server._tick.count() / 1000;
+                period.it_interval.tv_nsec = server._tick.count() % 1000 * 1000000;
+                period.it_value = period.it_interval;
+                Check(timerfd_settime(_timer, 0, &period, nullptr), "timerfd_settime");
+
+                // Exclusive, so a new connection wakes one shard rather than all of them
+                Watch(server._listener, EPOLLIN | EPOLLEXCLUSIVE);
+                Watch(server._stop, EPOLLIN);
+                Watch(_timer, EPOLLIN);
+            }
+            catch (...)
+            {
+                if (_timer >= 0)
+                {
+                    close(_timer);
+                }
+
+                close(_epoll);
+                throw;
+            }
+        }
+
+        ~Shard()
+        {
+            for (auto& session : _sessions)
+            {
+                close(session.first);
+            }
+
+            _server._sessions.fetch_sub(_sessions.size(), std::memory_order_relaxed);
+            close(_timer);
+            close(_epoll);
+        }
+
+        void Run()
+        {
+            epoll_event events[256];
+
+            while (true)
+            {
+                auto count = epoll_wait(_epoll, events, 256, -1);
+
+                if (count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+
+                Check(count, "epoll_wait");
+
+                for (int n = 0; n < count; n++)
+                {
+                    auto fd = events[n].data.fd;
+
+                    if (fd == _server._stop)
+                    {
+                        return;
+                    }
+
+                    if (fd == _server._listener)
+                    {
+                        Accept();
+                    }
+                    else if (fd == _timer)
+                    {
+                        uint64_t expirations;
+                        auto got = read(_timer, &expirations, sizeof(expirations));
+                        (void)got;
+                        Tick();
+                    }
+                    else
+                    {
+                        Serve(fd, events[n].events);
+                    }
+                }
+            }
+        }
+
+    private:
+        Server& _server;
+        int _epoll;
+        int _timer;
+        uint64_t _random;
+        std::unordered_map<int, std::unique_ptr<Session>> _sessions;
+
+        void Watch(int fd, uint32_t events)
+        {
+            epoll_event event{};
+            event.events = events;
+            event.data.fd = fd;
+            Check(epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event), "epoll_ctl");
+        }
+
+        // splitmix64, to seed new games
+        uint64_t NextRandom()
+        {
+            uint64_t z = (_random += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        void Accept()
+        {
+            while (true)
+            {
+                auto fd = accept4(_server._listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+                if (fd < 0)
+                {
+                    // EAGAIN once another shard has taken the connection
+                    return;
+                }
+
+                // A connection the shard cannot watch is turned away, not the shard
+                // taken down with it
+                try
+                {
+                    Watch(fd, EPOLLIN | EPOLLRDHUP);
+                }
+                catch (std::system_error&)
+                {
+                    close(fd);
+                    continue;
+                }
+
+                auto session = std::make_unique<Session>();
+                session->socket = fd;
+                session->blocked = false;
+
+                auto& out = session->pending;
+                out.push_back('H');
+                out.push_back(uint8_t(width));
+                out.push_back(uint8_t(width >> 8));
+                out.push_back(uint8_t(height));
+                out.push_back(uint8_t(height >> 8));
+
+                auto& started = *session;
+                _sessions.emplace(fd, std::move(session));
+                _server._sessions.fetch_add(1, std::memory_order_relaxed);
+                Start(started);
+            }
+        }
+
+        // Returns false if the client was dropped
+        bool Start(Session& session)
+        {
+            session.game.Reset(NextRandom());
+            session.turnCount = 0;
+            session.alive = true;
+
+            session.stream.RequestKeyframe();
+            session.stream.Encode(session.game, true, session.pending);
+            return Flush(session);
+        }
+
+        void Serve(int fd, uint32_t events)
+        {
+            auto found = _sessions.find(fd);
+
+            if (found == _sessions.end())
+            {
+                return;
+            }
+
+            auto& session = *found->second;
+
+            if (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+            {
+                Drop(fd);
+                return;
+            }
+
+            if (events & EPOLLOUT && !Flush(session))
+            {
+                return;
+            }
+
+            if (events & EPOLLIN)
+            {
+                uint8_t input[64];
+                auto got = read(fd, input, sizeof(input));
+
+                if (got == 0 || (got < 0 && errno != EAGAIN && errno != EINTR))
+                {
+                    Drop(fd);
+                    return;
+                }
+
+                for (ssize_t n = 0; n < got; n++)
+                {
+                    if (input[n] < 4)
+                    {
+                        QueueTurn(session, Direction(input[n]));
+                    }
+                    else if (input[n] == 'R' && !Start(session))
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+
+        static void QueueTurn(Session& session, Direction direction)
+        {
+            auto last = session.turnCount ? session.turns[session.turnCount - 1] : session.game.GetDirection();
+
+            if (direction != last && session.turnCount < MaxTurns)
+            {
+                session.turns[session.turnCount++] = direction;
+            }
+        }
+
+        void Tick()
+        {
+            std::vector<int> dropped;
+
+            for (auto& entry : _sessions)
+            {
+                auto& session = *entry.second;
+
+                if (!session.alive)
+                {
+                    continue;
+                }
+
+                if (session.turnCount)
+                {
+                    session.game.SetDirection(session.turns[0]);
+                    std::memmove(session.turns, session.turns + 1, --session.turnCount * sizeof(Direction));
+                }
+
+                session.alive = session.game.TryTick();
+                session.stream.Encode(session.game, session.alive, session.pending);
+
+                if (!Flush(session, false))
+                {
+                    dropped.push_back(entry.first);
+                }
+            }
+
+            for (auto fd : dropped)
+            {
+                Drop(fd);
+            }
+        }
+
+        // Sends what it can and waits for EPOLLOUT for the rest. Returns false if
+        // the client was dropped, or if it has to be when drop is not set
+        bool Flush(Session& session, bool drop = true)
+        {
+            auto& out = session.pending;
+            size_t sent = 0;
+
+            while (sent < out.size())
+            {
+                auto n = send(session.socket, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    if (errno != EAGAIN)
+                    {
+                        return Fail(session, drop);
+                    }
+
+                    break;
+                }
+
+                sent += size_t(n);
+            }
+
+            out.erase(out.begin(), out.begin() + ptrdiff_t(sent));
+
+            if (out.size() > MaxPending)
+            {
+                return Fail(session, drop);
+            }
+
+            // Only a client that stops keeping up costs an extra syscall
+            if (session.blocked != !out.empty())
+            {
+                session.blocked = !out.empty();
+
+                epoll_event event{};
+                event.events = EPOLLIN | EPOLLRDHUP | (session.blocked ? uint32_t(EPOLLOUT) : 0u);
+                event.data.fd = session.socket;
+                epoll_ctl(_epoll, EPOLL_CTL_MOD, session.socket, &event);
+            }
+
+            return true;
+        }
+
+        bool Fail(Session& session, bool drop)
+        {
+            if (drop)
+            {
+                Drop(session.socket);
+            }
+
+            return false;
+        }
+
+        void Drop(int fd)
+        {
+            epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+            close(fd);
+            _sessions.erase(fd);
+            _server._sessions.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::string _path;
+    std::chrono::milliseconds _tick;
+    size_t _shards;
+    int _listener;
+    int _stop;
+    std::atomic<size_t> _sessions;
+
+    static int Check(int result, const char* what)
+    {
+        if (result < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        return result;
+    }
+};
@@ -1,63 +1,69 @@
 #pragma once
 
 #define OLC_PGE_APPLICATION
+#if !defined(OLC_PLATFORM_HEADLESS)
 #define OLC_GFX_OPENGL10
+#endif
 #include "olcPixelGameEngine.h"
+#include "Game.hpp"
+#include "Autopilot.hpp"
+#include "Hamiltonian.hpp"
+#include "Mcts.hpp"
+#include "ControlChannel.hpp"
+#include "LevelGenerator.hpp"
+#include "ScoreStore.hpp"
 
 #include <vector>
 #include <map>
+#include <deque>
+#include <memory>
 
-class GameOver :
-        public std::exception
-{
-public:
-    GameOver(std::string what) :
-        _what(what)
-    {}
-
-    const char* what() const noexcept final override
-    {
-        return _what.c_str();
-    }
+constexpr static const auto Dead = true;
 
-private:
-    std::string _what;
+enum class Pilot
+{
+    Keyboard,
+    Autopilot,
+    Hamiltonian,
+    Mcts
 };
 
-constexpr static const auto Dead = true;
+auto GetTimeMs(const std::chrono::system_clock::time_point& tp)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+}
 
 auto GetTimeMs()
 {
-    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    return GetTimeMs(std::chrono::system_clock::now());
 }
 
-using Coordinates = std::pair<int, int>;
-
 template <int screenWidth, int screenHeight, int pixelWidth, int pixelHeight>
 class Snake :
         public olc::PixelGameEngine
 {
 public:
     Snake() :
-        _currentDirection(Direction::North),
+        _pilot(Pilot::Keyboard),
         _lastTickMs(GetTimeMs()),
-        _tickCount(0),
-        _run(true)
+        _seed(_lastTickMs),
+        _round(0),
+        _run(true),
+        _kiosk(false),
+        _restart(false)
     {
         sAppName = "Snake";
+        _game.Seed(_seed);
 
         if (!Construct(screenWidth, screenHeight, pixelWidth, pixelHeight))
         {
             throw "Could not construct snake!";
         }
-
-        Start();
     }
 
     bool OnUserCreate() final override
     {
-        SetBackground(olc::BLACK);        
-        CreateInitialSnake();
+        SetBackground(olc::BLACK);
         return true;
     }
 
@@ -65,305 +71,290 @@ public:
     {
         try
         {
+            // Kiosks and endless play go straight on to the next game, a frame
+            // after showing the last one lost
+            if (_restart || (!_run && (_kiosk || _levels)))
+            {
+                Restart();
+            }
+
             if (_run)
             {
                 DoOnUserUpdate();
             }
+            else
+            {
+                for (auto& event : GetInputEvents())
+                {
+                    HandleInput(event);
+                }
+            }
         }
         catch (GameOver&)
         {
             _run = false;
             DrawTheSnake(Dead);
+
+            if (_scores)
+            {
+                _scores->Submit(ScoreStore::Finish(_game, false, _seed));
+            }
+
+            if (_control)
+            {
+                _control->Publish(_game, false);
+            }
         }
 
         return true;
     }
 
-private:
-    enum class Direction
+    void SetPilot(Pilot pilot)
     {
-        North,
-        East,
-        South,
-        West
-    };
-
-    std::vector<Coordinates> _snake;
-    std::vector<Coordinates> _goodObstacles;
-    std::vector<Coordinates> _badObstacles;
-    Direction _currentDirection;
-    size_t _lastTickMs;
-    size_t _tickCount;
-    bool _run;
+        if (pilot == Pilot::Autopilot && _pilot != Pilot::Autopilot)
+        {
+            _autopilot.Attach(_game);
+        }
 
-    void DoOnUserUpdate()
-    {
-        auto now = GetTimeMs();
-        if (now - _lastTickMs > 50)
+        if (pilot == Pilot::Mcts && !_mcts)
         {
-            Tick();
-            _lastTickMs = now;
-            _tickCount++;
+            _workers = std::make_unique<WorkerPool>();
+            _mcts = std::make_unique<Mcts<screenWidth, screenHeight>>(*_workers);
         }
 
-        HandleInput();
+        _pilot = pilot;
     }
 
-    template <typename T>
-    void MoveNorth(T& x)
+    // Plays on a level's walls rather than the bare border; call before Start()
+    void LoadLevel(const std::string& path)
     {
-        x--;
+        _game = Game<screenWidth, screenHeight>(Level(path));
+        _game.Seed(_seed);
     }
 
-    template <typename T>
-    void MoveSouth(T& x)
+    // Plays round after round, each on a new level, generating the next level while
+    // the current round is played
+    void EnableEndless()
     {
-        x++;
+        _levels = std::make_unique<LevelGenerator<screenWidth, screenHeight>>();
+        _levels->Prepare(_lastTickMs);
+        Restart();
     }
 
-    template <typename T>
-    void MoveEast(T& y)
-    {
-        y++;
-    }
-
-    template <typename T>
-    void MoveWest(T& y)
+    // Starts the next game in this window, one frame after the last one is lost
+    void EnableKiosk()
     {
-        y--;
+        _kiosk = true;
     }
 
-    template <typename T>
-    void SetBackground(T& t)
+    // Plays again in the same window without building anything new: the game is
+    // reset in its own storage, on the next level in endless mode and on the same
+    // walls otherwise
+    void Restart()
     {
-        for (int x = 0; x < ScreenWidth(); x++)
+        // A game given up part way still counts as a run
+        if (_scores && _run && _game.TickCount() > 0)
         {
-            for (int y = 0; y < ScreenHeight(); y++)
-            {                
-                if (IsBorder(x, y))
-                {
-                    Draw(x, y, olc::GREY);
-                }
+            _scores->Submit(ScoreStore::Finish(_game, true, _seed));
+        }
 
-                else
-                {
-                    Draw(x, y, t);
-                }
-            }
-        }       
-    }
+        _seed = GetTimeMs();
 
-    template <typename T>
-    bool IsBorder(T x, T y)
-    {
-        if (x == 0)
+        if (_levels)
         {
-            return true;
+            _game.Reset(_seed, _levels->Take());
+            _levels->Prepare(_lastTickMs + ++_round);
         }
-
-        else if (x == ScreenWidth() - 1)
+        else
         {
-            return true;
+            _game.Reset(_seed);
         }
 
-        else if (y == 0)
+        _turns.clear();
+        _run = true;
+        _restart = false;
+
+        if (_pilot == Pilot::Autopilot)
         {
-            return true;
+            _autopilot.Attach(_game);
         }
 
-        else if (y == ScreenHeight() - 1)
+        if (_control)
         {
-            return true;
+            _control->Publish(_game);
         }
+    }
 
-        return false;
+    // Lets another process read the game and steer it as the arrow keys would
+    void EnableControl(const std::string& name)
+    {
+        _control = std::make_unique<ControlChannel<screenWidth, screenHeight>>(name, ControlChannel<screenWidth, screenHeight>::Mode::Create);
+        _control->Publish(_game);
     }
 
-    constexpr void HandleInput()
+    // Records every run in the score log at path, written behind the game's back
+    void EnableScores(const std::string& path)
     {
-        if (GetKey(olc::Key::UP).bReleased)
-        {
-            _currentDirection = Direction::North;            
-        }
+        _scores = std::make_unique<ScoreStore>(path);
+    }
 
-        if (GetKey(olc::Key::RIGHT).bReleased)
-        {
-            _currentDirection = Direction::East;            
-        }
+private:
+    Game<screenWidth, screenHeight> _game;
+    Autopilot<screenWidth, screenHeight> _autopilot;
+    std::unique_ptr<WorkerPool> _workers;
+    std::unique_ptr<Mcts<screenWidth, screenHeight>> _mcts;
+    std::unique_ptr<ControlChannel<screenWidth, screenHeight>> _control;
+    std::unique_ptr<ScoreStore> _scores;
+    Pilot _pilot;
+    std::deque<Direction> _turns;
+    std::unique_ptr<LevelGenerator<screenWidth, screenHeight>> _levels;
+    size_t _lastTickMs;
+    uint64_t _seed;
+    uint64_t _round;
+    bool _run;
+    bool _kiosk;
+    bool _restart;
 
-        if (GetKey(olc::Key::DOWN).bReleased)
-        {
-            _currentDirection = Direction::South;            
-        }
+    void DoOnUserUpdate()
+    {
+        // Turns pressed before the tick was due belong to this tick, later ones to the next
+        auto& events = GetInputEvents();
+        size_t n = 0;
 
-        if (GetKey(olc::Key::LEFT).bReleased)
+        for (; n < events.size() && size_t(GetTimeMs(events[n].tp)) <= _lastTickMs + 50; n++)
         {
-            _currentDirection = Direction::West;            
+            HandleInput(events[n]);
         }
-    }
-
-    constexpr void Tick()
-    {
-        FollowTheSnakeHead();
-        MoveTheSnakeHead();
-        SetBackground(olc::BLACK);
-        DrawTheObstacles();
-        DrawTheSnake();
 
-        if (_tickCount % 10 == 0)
+        Direction direction;
+        while (_control && _control->Receive(direction))
         {
-            AppendTheSnake();
+            QueueTurn(direction);
         }
 
-        if (_tickCount % 30 == 0)
+        auto now = GetTimeMs();
+        if (now - _lastTickMs > 50)
         {
-            CreateObstacle();
+            Tick();
+            _lastTickMs = now;
         }
-    }
 
-    void CreateInitialSnake()
-    {
-        _snake.push_back(std::make_pair(screenWidth / 2, screenHeight / 2));
-        _snake.push_back(std::make_pair(_snake.back().first, _snake.back().second+1));
-        _snake.push_back(std::make_pair(_snake.back().first, _snake.back().second+1));
-        _snake.push_back(std::make_pair(_snake.back().first, _snake.back().second+1));
-        _snake.push_back(std::make_pair(_snake.back().first, _snake.back().second+1));
-    }
-
-    constexpr void AppendTheSnake(int x = 1)
-    {
-        for (int n = 0; n < x; n++)
+        for (; n < events.size(); n++)
         {
-            auto last = _snake.back();
-
-            switch (_currentDirection)
-            {
-                case Direction::North: MoveNorth(last.second); break;
-                case Direction::East:  MoveEast(last.first); break;
-                case Direction::South: MoveSouth(last.second); break;
-                case Direction::West:  MoveWest(last.first); break;
-            }
-
-            _snake.push_back(last);
+            HandleInput(events[n]);
         }
     }
 
-    constexpr void DrawTheSnake(bool dead = false)
+    template <typename T>
+    void SetBackground(T& t)
     {
-        for (size_t n = 0; n < _snake.size(); n++)
-        {            
-            auto color = dead ? olc::RED : olc::GREEN;
+        for (int x = 0; x < ScreenWidth(); x++)
+        {
+            for (int y = 0; y < ScreenHeight(); y++)
+            {                
+                if (_game.IsWall(std::make_pair(x, y)))
+                {
+                    Draw(x, y, olc::GREY);
+                }
 
-            if (n == 0)
-            {
-                color = olc::VERY_DARK_GREEN;
+                else
+                {
+                    Draw(x, y, t);
+                }
             }
-
-            auto& c = _snake.at(n);
-            Draw(c.first, c.second, color);
-        }
+        }       
     }
 
-    constexpr void DrawTheObstacles()
+    void HandleInput(const olc::InputEvent& event)
     {
-        for (auto& c : _goodObstacles)
+        if (event.type != olc::InputEvent::KEY_DOWN)
         {
-            Draw(c.first, c.second, olc::CYAN);
+            return;
         }
 
-        for (auto& c : _badObstacles)
+        switch (event.nCode)
         {
-            Draw(c.first, c.second, olc::MAGENTA);
+            case olc::Key::UP:    QueueTurn(Direction::North); break;
+            case olc::Key::RIGHT: QueueTurn(Direction::East); break;
+            case olc::Key::DOWN:  QueueTurn(Direction::South); break;
+            case olc::Key::LEFT:  QueueTurn(Direction::West); break;
+            case olc::Key::A:     SetPilot(_pilot == Pilot::Autopilot ? Pilot::Keyboard : Pilot::Autopilot); break;
+            case olc::Key::H:     SetPilot(_pilot == Pilot::Hamiltonian ? Pilot::Keyboard : Pilot::Hamiltonian); break;
+            case olc::Key::M:     SetPilot(_pilot == Pilot::Mcts ? Pilot::Keyboard : Pilot::Mcts); break;
+            case olc::Key::R:     _restart = true; break;
+            default: break;
         }
     }
 
-    constexpr void MoveTheSnakeHead()
+    // Each tick takes one turn, so quick presses land on consecutive ticks instead of merging
+    void QueueTurn(Direction direction)
     {
-        auto& head = _snake.front();
+        auto last = _turns.empty() ? _game.GetDirection() : _turns.back();
 
-        switch (_currentDirection)
+        if (direction != last && _turns.size() < 3)
         {
-            case Direction::North: MoveNorth(head.second); break;
-            case Direction::East:  MoveEast(head.first); break;
-            case Direction::South: MoveSouth(head.second); break;
-            case Direction::West:  MoveWest(head.first); break;
+            _turns.push_back(direction);
         }
-
-        CheckCollosion();
     }
 
-    constexpr void CheckCollosion()
+    void Tick()
     {
-        auto& head = _snake.front();
-
-        for (size_t n = 1; n < _snake.size(); n++)
+        if (_pilot == Pilot::Autopilot)
         {
-            auto& c = _snake.at(n);
-
-            if ((c.first == head.first) && (c.second == head.second))
-            {
-                throw GameOver("Collision");
-            }
-
-            if (IsBorder(head.first, head.second))
-            {
-                throw GameOver("Collision");
-            }
+            _turns.clear();
+            _autopilot.Update(_game);
+            _game.SetDirection(_autopilot.Steer(_game));
         }
-
-        for (auto& c : _badObstacles)
+        else if (_pilot == Pilot::Hamiltonian)
         {
-            if ((c.first == head.first) && (c.second == head.second))
-            {
-                throw GameOver("Collision");
-            }
+            _turns.clear();
+            _game.SetDirection(Hamiltonian<screenWidth, screenHeight>::Steer(_game));
         }
-
-        for (auto& c : _goodObstacles)
+        else if (_pilot == Pilot::Mcts)
         {
-            if ((c.first == head.first) && (c.second == head.second))
-            {
-                _goodObstacles.clear();
-                _badObstacles.clear();
-                AppendTheSnake(5);
+            _turns.clear();
+            _game.SetDirection(_mcts->Plan(_game));
+        }
+        else if (!_turns.empty())
+        {
+            _game.SetDirection(_turns.front());
+            _turns.pop_front();
+        }
 
-                CreateObstacle();
-                break;
-            }
+        _game.Tick();
+
+        if (_control)
+        {
+            _control->Publish(_game);
         }
+
+        SetBackground(olc::BLACK);
+        DrawTheObstacles();
+        DrawTheSnake();
     }
 
-    constexpr void FollowTheSnakeHead()
+    constexpr void DrawTheSnake(bool dead = false)
     {
-        Coordinates last = {0,0};
+        for (size_t n = 0; n < _game.Length(); n++)
+        {            
+            auto color = dead ? olc::RED : olc::GREEN;
 
-        for (size_t n = 0; n < _snake.size(); n++)
-        {
             if (n == 0)
             {
-                last = _snake.at(n);
-            }
-            else
-            {
-                auto buffer = _snake.at(n);
-                _snake[n] = last;
-                last = buffer;
+                color = olc::VERY_DARK_GREEN;
             }
+
+            auto c = _game.Body(n);
+            Draw(c.first, c.second, color);
         }
     }
 
-    constexpr void CreateObstacle()
+    constexpr void DrawTheObstacles()
     {
-        auto x = _lastTickMs % ScreenWidth();
-        auto y = _lastTickMs % ScreenHeight();
-
-        if (_lastTickMs % 3 == 0)
-        {
-            _goodObstacles.push_back(std::make_pair(x,y));
-        }
-        else
+        for (size_t n = 0; n < _game.ObstacleCount(); n++)
         {
-            _badObstacles.push_back(std::make_pair(x,y));
+            auto c = _game.Obstacle(n);
+            Draw(c.first, c.second, _game.IsBad(c) ? olc::MAGENTA : olc::CYAN);
         }
     }
 };
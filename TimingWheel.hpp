@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+// Timers for a simulation that counts in ticks, kept in a hierarchy of wheels of
+// 64 slots each. The first wheel holds what is due in the next 64 ticks, one slot
+// per tick; every wheel above it holds 64 times as far ahead, one slot per turn of
+// the wheel below, and a slot is only spread out into the wheels below when its
+// turn comes. Scheduling and cancelling are O(1), and a tick costs the timers it
+// fires plus, once every 64 ticks, the timers it moves down a wheel.
+//
+// Timers live in a fixed pool linked by 16-bit indices, so the wheel is trivially
+// copyable along with whatever owns it. Both the pool and the number of wheels are
+// fixed by the owner, which pays for them in every copy.
+template <size_t capacity, int levels = 4>
+class TimingWheel
+{
+    static_assert(capacity < UINT16_MAX, "Timers are linked by 16-bit indices");
+    static_assert(levels >= 2 && levels <= 5, "Timers beyond reach wait in the top wheel, above at least one other");
+
+public:
+    // Names one scheduled timer; stays safe to cancel after the timer fired
+    using Handle = uint32_t;
+
+    static constexpr size_t Capacity = capacity;
+
+    TimingWheel()
+    {
+        Clear();
+    }
+
+    // Drops every timer and starts again from tick 0, in the same storage
+    void Clear()
+    {
+        _slots.fill(Nowhere);
+        _now = 0;
+        _used = 0;
+        _free = Nowhere;
+        _pending = 0;
+    }
+
+    // The tick the next Advance() fires
+    constexpr uint32_t Now() const
+    {
+        return _now;
+    }
+
+    constexpr size_t Pending() const
+    {
+        return _pending;
+    }
+
+    // Fires payload on tick when, or on the next Advance() if when has passed.
+    // Throws if every timer is taken
+    Handle Schedule(uint32_t when, uint32_t payload)
+    {
+        auto index = Allocate();
+        auto& timer = _timers[index];
+        timer.when = int32_t(when - _now) < 0 ? _now : when;
+        timer.payload = payload;
+        Insert(index);
+        _pending++;
+        return Handle(timer.generation) << 16 | index;
+    }
+
+    // Returns false if the timer has already fired or been cancelled
+    bool Cancel(Handle handle)
+    {
+        auto index = uint16_t(handle);
+
+        if (index >= _used || _timers[index].generation != uint16_t(handle >> 16) || _timers[index].slot == Unused)
+        {
+            return false;
+        }
+
+        Unlink(index);
+        Release(index);
+        return true;
+    }
+
+    // Fires every timer due on the current tick with its payload, in no particular
+    // order, and moves on to the next tick. fire may schedule and cancel timers
+    template <typename F>
+    void Advance(F&& fire)
+    {
+        auto tick = _now;
+
+        if ((tick & SlotMask) == 0)
+        {
+            Cascade(tick);
+        }
+
+        // Taken off the wheel first, so fire can cancel the timers still to come
+        auto& firing = _slots[Firing];
+        for (auto index = _slots[tick & SlotMask]; index != Nowhere; index = _timers[index].next)
+        {
+            _timers[index].slot = Firing;
+        }
+
+        firing = _slots[tick & SlotMask];
+        _slots[tick & SlotMask] = Nowhere;
+        _now = tick + 1;
+
+        while (firing != Nowhere)
+        {
+            auto index = firing;
+            auto payload = _timers[index].payload;
+            Unlink(index);
+            Release(index);
+            fire(payload);
+        }
+    }
+
+private:
+    static constexpr int SlotBits = 6;
+    static constexpr uint32_t SlotMask = (1u << SlotBits) - 1;
+    static constexpr int Levels = levels;
+    static constexpr uint32_t Range = uint32_t((uint64_t(1) << SlotBits * Levels) - 1);
+    static constexpr uint16_t Firing = Levels << SlotBits;
+    static constexpr uint16_t Unused = Firing + 1;
+    static constexpr uint16_t Nowhere = UINT16_MAX;
+
+    struct Timer
+    {
+        uint32_t when;
+        uint32_t payload;
+        uint16_t next;
+        uint16_t prev;
+        uint16_t slot;
+        uint16_t generation;
+    };
+
+    std::array<Timer, capacity> _timers;
+    // The wheels one after the other, then the timers being fired
+    std::array<uint16_t, (Levels << SlotBits) + 1> _slots;
+    uint32_t _now;
+    uint16_t _used;
+    uint16_t _free;
+    uint32_t _pending;
+
+    // Timers are only initialised as the pool first reaches them, so a new wheel
+    // costs its slots and nothing more
+    uint16_t Allocate()
+    {
+        if (_free != Nowhere)
+        {
+            auto index = _free;
+            _free = _timers[index].next;
+            return index;
+        }
+
+        if (_used == capacity)
+        {
+            throw std::length_error("Timing wheel is full");
+        }
+
+        _timers[_used].generation = 0;
+        return _used++;
+    }
+
+    void Release(uint16_t index)
+    {
+        auto& timer = _timers[index];
+        timer.slot = Unused;
+        timer.generation++;
+        timer.next = _free;
+        _free = index;
+        _pending--;
+    }
+
+    // The lowest wheel whose reach covers the wait, in the slot for when's turn.
+    // Beyond the top wheel's reach a timer waits in its furthest slot and is
+    // placed again when that comes round
+    void Insert(uint16_t index)
+    {
+        auto& timer = _timers[index];
+        auto wait = timer.when - _now;
+        auto at = wait > Range ? _now + Range : timer.when;
+        int level = 0;
+
+        while (level < Levels - 1 && std::min(wait, Range) >> SlotBits * (level + 1))
+        {
+            level++;
+        }
+
+        timer.slot = uint16_t(level << SlotBits | (at >> SlotBits * level & SlotMask));
+        timer.prev = Nowhere;
+        timer.next = _slots[timer.slot];
+
+        if (timer.next != Nowhere)
+        {
+            _timers[timer.next].prev = index;
+        }
+
+        _slots[timer.slot] = index;
+    }
+
+    void Unlink(uint16_t index)
+    {
+        auto& timer = _timers[index];
+
+        if (timer.prev != Nowhere)
+        {
+            _timers[timer.prev].next = timer.next;
+        }
+        else
+        {
+            _slots[timer.slot] = timer.next;
+        }
+
+        if (timer.next != Nowhere)
+        {
+            _timers[timer.next].prev = timer.prev;
+        }
+    }
+
+    // On a tick where the wheels below have come round, the slots whose turn it is
+    // are spread out again. The highest goes first, so what it drops into a lower
+    // wheel is spread out in turn on this same tick
+    void Cascade(uint32_t tick)
+    {
+        int top = 1;
+
+        while (top < Levels - 1 && (tick & ((1u << SlotBits * (top + 1)) - 1)) == 0)
+        {
+            top++;
+        }
+
+        for (int level = top; level > 0; level--)
+        {
+            auto& slot = _slots[level << SlotBits | (tick >> SlotBits * level & SlotMask)];
+            auto index = slot;
+            slot = Nowhere;
+
+            while (index != Nowhere)
+            {
+                auto next = _timers[index].next;
+                Insert(index);
+                index = next;
+            }
+        }
+    }
+};
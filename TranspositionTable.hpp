@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Fixed-size hash table from position hashes to 64 bits of data, shared by search
+// threads without locks. Each slot stores the key xored with its data. A slot torn
+// by two concurrent writers then fails the check on Probe() and reads as a miss,
+// instead of returning one writer's key with the other's data. Collisions simply
+// overwrite.
+class TranspositionTable
+{
+public:
+    explicit TranspositionTable(size_t log2Entries = 18) :
+        _entries(new Entry[size_t(1) << log2Entries]),
+        _mask((size_t(1) << log2Entries) - 1)
+    {
+        Clear();
+    }
+
+    void Clear()
+    {
+        for (size_t n = 0; n <= _mask; n++)
+        {
+            _entries[n].check.store(0, std::memory_order_relaxed);
+            _entries[n].data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    bool Probe(uint64_t key, uint64_t& data) const
+    {
+        auto& entry = _entries[key & _mask];
+        auto check = entry.check.load(std::memory_order_relaxed);
+        auto value = entry.data.load(std::memory_order_relaxed);
+
+        if ((check ^ value) != key)
+        {
+            return false;
+        }
+
+        data = value;
+        return true;
+    }
+
+    void Store(uint64_t key, uint64_t data)
+    {
+        auto& entry = _entries[key & _mask];
+        entry.check.store(key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
+
+private:
+    struct Entry
+    {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Entry[]> _entries;
+    size_t _mask;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads that stay alive between jobs. Run() hands the same job to every worker,
+// along with the worker's number, and returns once all of them have finished.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(size_t workers = std::max(1u, std::thread::hardware_concurrency())) :
+        _job(nullptr),
+        _generation(0),
+        _pending(0),
+        _stop(false)
+    {
+        for (size_t n = 0; n < workers; n++)
+        {
+            _threads.emplace_back([this, n]() { Work(n); });
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+
+        _wake.notify_all();
+
+        for (auto& thread : _threads)
+        {
+            thread.join();
+        }
+    }
+
+    size_t Size() const
+    {
+        return _threads.size();
+    }
+
+    void Run(const std::function<void(size_t)>& job)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _job = &job;
+        _pending = _threads.size();
+        _generation++;
+        _wake.notify_all();
+        _done.wait(lock, [this]() { return _pending == 0; });
+        _job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const std::function<void(size_t)>* _job;
+    size_t _generation;
+    size_t _pending;
+    bool _stop;
+
+    void Work(size_t worker)
+    {
+        size_t seen = 0;
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        while (true)
+        {
+            _wake.wait(lock, [this, seen]() { return _stop || _generation != seen; });
+
+            if (_stop)
+            {
+                return;
+            }
+
+            seen = _generation;
+            auto job = _job;
+
+            lock.unlock();
+            (*job)(worker);
+            lock.lock();
+
+            if (--_pending == 0)
+            {
+                _done.notify_one();
+            }
+        }
+    }
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "ChunkedBoard.hpp"
+#include "Game.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// The rules of Game on a board sized at runtime and stored in a ChunkedBoard, so
+// memory follows the snake and the obstacles rather than the board.
+class World
+{
+public:
+    World(int width, int height, uint64_t seed = 0) :
+        _board(width, height),
+        _currentDirection(Direction::North),
+        _growth(0),
+        _random(seed),
+        _tickCount(0),
+        _score(0)
+    {
+        CreateInitialSnake();
+    }
+
+    int Width() const
+    {
+        return int(_board.Width());
+    }
+
+    int Height() const
+    {
+        return int(_board.Height());
+    }
+
+    bool IsBorder(int x, int y) const
+    {
+        return x == 0 || x == Width() - 1 || y == 0 || y == Height() - 1;
+    }
+
+    // True for the border and beyond, the snake and bad obstacles
+    bool IsBlocked(const Coordinates& c) const
+    {
+        return !_board.InBounds(c.first, c.second) || IsBorder(c.first, c.second) ||
+               (_board.Get(c.first, c.second) & (BodyMask | Bad));
+    }
+
+    bool IsBody(const Coordinates& c) const
+    {
+        return _board.Get(c.first, c.second) & BodyMask;
+    }
+
+    bool IsGood(const Coordinates& c) const
+    {
+        return _board.Get(c.first, c.second) & Good;
+    }
+
+    bool IsBad(const Coordinates& c) const
+    {
+        return _board.Get(c.first, c.second) & Bad;
+    }
+
+    const ChunkedBoard& Board() const
+    {
+        return _board;
+    }
+
+    Direction GetDirection() const
+    {
+        return _currentDirection;
+    }
+
+    void SetDirection(Direction direction)
+    {
+        _currentDirection = direction;
+    }
+
+    size_t Length() const
+    {
+        return _snake.size();
+    }
+
+    // Body(0) is the head, Body(Length() - 1) the tail
+    Coordinates Body(size_t n) const
+    {
+        return _snake[n];
+    }
+
+    Coordinates Head() const
+    {
+        return _snake.front();
+    }
+
+    size_t ObstacleCount() const
+    {
+        return _obstacles.size();
+    }
+
+    Coordinates Obstacle(size_t n) const
+    {
+        return _obstacles[n];
+    }
+
+    size_t TickCount() const
+    {
+        return _tickCount;
+    }
+
+    size_t Score() const
+    {
+        return _score;
+    }
+
+    void Tick()
+    {
+        if (!TryTick())
+        {
+            throw GameOver("Collision");
+        }
+    }
+
+    bool TryTick()
+    {
+        auto entropy = size_t(NextRandom());
+
+        FollowTheSnakeHead();
+
+        if (!MoveTheSnakeHead(entropy))
+        {
+            return false;
+        }
+
+        if (_tickCount % 10 == 0)
+        {
+            _growth++;
+        }
+
+        if (_tickCount % 30 == 0)
+        {
+            CreateObstacle(entropy);
+        }
+
+        _tickCount++;
+        return true;
+    }
+
+private:
+    // Same cell layout as Game: a body count plus obstacle flags
+    static constexpr uint8_t BodyMask = 0x3F;
+    static constexpr uint8_t Good = 0x40;
+    static constexpr uint8_t Bad = 0x80;
+
+    ChunkedBoard _board;
+    std::deque<Coordinates> _snake;
+    std::vector<Coordinates> _obstacles;
+    Direction _currentDirection;
+    size_t _growth;
+    uint64_t _random;
+    size_t _tickCount;
+    size_t _score;
+
+    // splitmix64
+    uint64_t NextRandom()
+    {
+        uint64_t z = (_random += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    void Change(const Coordinates& c, int body, uint8_t set = 0, uint8_t clear = 0)
+    {
+        auto cell = _board.Get(c.first, c.second);
+        _board.Set(c.first, c.second, uint8_t(((cell + body) & ~clear) | set));
+    }
+
+    void Step(Coordinates& c) const
+    {
+        switch (_currentDirection)
+        {
+            case Direction::North: c.second--; break;
+            case Direction::East:  c.first++; break;
+            case Direction::South: c.second++; break;
+            case Direction::West:  c.first--; break;
+        }
+    }
+
+    void CreateInitialSnake()
+    {
+        for (int n = 0; n < 5; n++)
+        {
+            _snake.push_back(std::make_pair(Width() / 2, Height() / 2 + n));
+            Change(_snake.back(), 1);
+        }
+    }
+
+    // As in Game, growth is owed and paid by keeping the tail
+    void FollowTheSnakeHead()
+    {
+        if (_growth > 0)
+        {
+            _growth--;
+            return;
+        }
+
+        Change(_snake.back(), -1);
+        _snake.pop_back();
+    }
+
+    bool MoveTheSnakeHead(size_t entropy)
+    {
+        auto head = _snake.front();
+        Step(head);
+
+        _snake.push_front(head);
+        Change(head, 1);
+
+        return CheckCollosion(entropy);
+    }
+
+    bool CheckCollosion(size_t entropy)
+    {
+        auto head = _snake.front();
+        auto cell = _board.Get(head.first, head.second);
+
+        if (IsBorder(head.first, head.second) || (cell & BodyMask) > 1 || (cell & Bad))
+        {
+            return false;
+        }
+
+        if (cell & Good)
+        {
+            for (auto& c : _obstacles)
+            {
+                Change(c, 0, 0, Good | Bad);
+            }
+
+            _obstacles.clear();
+            _score++;
+            _growth += 5;
+
+            CreateObstacle(entropy);
+        }
+
+        return true;
+    }
+
+    // As in Game, a taken cell passes the obstacle on to the next empty cell, though
+    // on a board this large only along its row, wrapping round, and a row that is
+    // full goes without
+    void CreateObstacle(size_t entropy)
+    {
+        auto c = std::make_pair(int(uint64_t(entropy) % uint64_t(Width())), int((uint64_t(entropy) >> 32) % uint64_t(Height())));
+
+        for (int n = 0; IsBorder(c.first, c.second) || _board.Get(c.first, c.second); n++)
+        {
+            if (n == Width())
+            {
+                return;
+            }
+
+            if (++c.first >= Width() - 1)
+            {
+                c.first = 1;
+            }
+        }
+
+        _obstacles.push_back(c);
+        Change(c, 0, (uint64_t(entropy) >> 16) % 3 == 0 ? Good : Bad);
+    }
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Snake.hpp"
+#include "World.hpp"
+
+#include <deque>
+
+// Snake on a World larger than the window: the screen is a camera that follows
+// the head and only the cells under it are read each frame.
+template <int screenWidth, int screenHeight, int pixelWidth, int pixelHeight>
+class WorldSnake :
+        public olc::PixelGameEngine
+{
+public:
+    WorldSnake(int width, int height) :
+        _world(width, height, GetTimeMs()),
+        _lastTickMs(GetTimeMs()),
+        _run(true)
+    {
+        sAppName = "Snake World";
+
+        if (!Construct(screenWidth, screenHeight, pixelWidth, pixelHeight))
+        {
+            throw "Could not construct snake!";
+        }
+    }
+
+    bool OnUserCreate() final override
+    {
+        DrawTheCamera();
+        return true;
+    }
+
+    bool OnUserUpdate(float) final override
+    {
+        for (auto& event : GetInputEvents())
+        {
+            HandleInput(event);
+        }
+
+        auto now = GetTimeMs();
+        if (_run && now - _lastTickMs > 50)
+        {
+            Tick();
+            _lastTickMs = now;
+        }
+
+        return true;
+    }
+
+private:
+    World _world;
+    std::deque<Direction> _turns;
+    size_t _lastTickMs;
+    bool _run;
+
+    void HandleInput(const olc::InputEvent& event)
+    {
+        if (event.type != olc::InputEvent::KEY_DOWN)
+        {
+            return;
+        }
+
+        switch (event.nCode)
+        {
+            case olc::Key::UP:    QueueTurn(Direction::North); break;
+            case olc::Key::RIGHT: QueueTurn(Direction::East); break;
+            case olc::Key::DOWN:  QueueTurn(Direction::South); break;
+            case olc::Key::LEFT:  QueueTurn(Direction::West); break;
+            default: break;
+        }
+    }
+
+    void QueueTurn(Direction direction)
+    {
+        auto last = _turns.empty() ? _world.GetDirection() : _turns.back();
+
+        if (direction != last && _turns.size() < 3)
+        {
+            _turns.push_back(direction);
+        }
+    }
+
+    void Tick()
+    {
+        if (!_turns.empty())
+        {
+            _world.SetDirection(_turns.front());
+            _turns.pop_front();
+        }
+
+        _run = _world.TryTick();
+        DrawTheCamera();
+    }
+
+    void DrawTheCamera()
+    {
+        auto head = _world.Head();
+        auto left = head.first - screenWidth / 2;
+        auto top = head.second - screenHeight / 2;
+
+        for (int y = 0; y < screenHeight; y++)
+        {
+            for (int x = 0; x < screenWidth; x++)
+            {
+                Draw(x, y, ColourOf(std::make_pair(left + x, top + y)));
+            }
+        }
+
+        Draw(head.first - left, head.second - top, _run ? olc::VERY_DARK_GREEN : olc::RED);
+    }
+
+    olc::Pixel ColourOf(const Coordinates& c) const
+    {
+        if (!_world.Board().InBounds(c.first, c.second))
+        {
+            return olc::VERY_DARK_GREY;
+        }
+
+        if (_world.IsBorder(c.first, c.second))
+        {
+            return olc::GREY;
+        }
+
+        if (_world.IsBody(c))
+        {
+            return _run ? olc::GREEN : olc::RED;
+        }
+
+        if (_world.IsBad(c))
+        {
+            return olc::MAGENTA;
+        }
+
+        return _world.IsGood(c) ? olc::CYAN : olc::BLACK;
+    }
+};
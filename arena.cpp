@@ -0,0 +1,19 @@
+#include "ArenaSnake.hpp"
+#include <cstdlib>
+
+// A crowded arena with the player as one snake among bots. With workers the arena
+// is stepped in parallel on that many threads.
+//
+//   SnakeArena [width] [height] [bots] [workers]
+
+int main(int argc, char** argv)
+{
+    int width = argc > 1 ? std::atoi(argv[1]) : 256;
+    int height = argc > 2 ? std::atoi(argv[2]) : width;
+    size_t bots = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 100;
+    size_t workers = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 0;
+
+    ArenaSnake<256 / 3, 240 / 3, 4 * 3, 4 * 3> snake(width, height, bots, workers);
+    snake.Start();
+    return 0;
+}
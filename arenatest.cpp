@@ -0,0 +1,186 @@
+#include "Arena.hpp"
+#include "Arguments.hpp"
+#include "WorkerPool.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// Steps the same crowded arena serially, on one worker and on many, in lockstep,
+// and compares the board, every snake and the obstacles after every tick. Then
+// times each of them alone and prints ticks per second. Stops at the first tick
+// the arenas disagree.
+//
+//   SnakeArenaTest [size] [snakes] [ticks] [workers]
+
+namespace
+{
+    uint64_t NextRandom(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Bots go wherever they fit, from the same seed in every arena
+    void Populate(Arena& arena, size_t snakes)
+    {
+        uint64_t random = 1;
+
+        for (size_t n = 0; n < snakes * 4 && arena.SnakeCount() < snakes; n++)
+        {
+            auto entropy = NextRandom(random);
+            auto head = std::make_pair(int(entropy % uint64_t(arena.Width())), int((entropy >> 32) % uint64_t(arena.Height())));
+            auto direction = Direction((entropy >> 16) % 4);
+
+            if (arena.CanPlace(head, direction))
+            {
+                arena.AddSnake(head, direction);
+            }
+        }
+    }
+
+    void Steer(Arena& arena, uint64_t& random)
+    {
+        for (size_t id = 0; id < arena.SnakeCount(); id++)
+        {
+            if (arena.IsAlive(id))
+            {
+                arena.SetDirection(id, arena.Wander(id, NextRandom(random)));
+            }
+        }
+    }
+
+    // Returns what differs, or nothing
+    std::string Compare(const Arena& a, const Arena& b)
+    {
+        if (a.Alive() != b.Alive() || a.ObstacleCount() != b.ObstacleCount() || a.Board().Chunks() != b.Board().Chunks())
+        {
+            return "alive " + std::to_string(a.Alive()) + " / " + std::to_string(b.Alive()) +
+                   ", obstacles " + std::to_string(a.ObstacleCount()) + " / " + std::to_string(b.ObstacleCount()) +
+                   ", chunks " + std::to_string(a.Board().Chunks()) + " / " + std::to_string(b.Board().Chunks());
+        }
+
+        for (size_t n = 0; n < a.ObstacleCount(); n++)
+        {
+            if (a.Obstacle(n) != b.Obstacle(n))
+            {
+                return "obstacle " + std::to_string(n);
+            }
+        }
+
+        for (size_t id = 0; id < a.SnakeCount(); id++)
+        {
+            if (a.IsAlive(id) != b.IsAlive(id) || a.Length(id) != b.Length(id) || a.Score(id) != b.Score(id) ||
+                a.GetDirection(id) != b.GetDirection(id))
+            {
+                return "snake " + std::to_string(id);
+            }
+
+            for (size_t n = 0; n < a.Length(id); n++)
+            {
+                if (a.Body(id, n) != b.Body(id, n))
+                {
+                    return "body of snake " + std::to_string(id);
+                }
+            }
+        }
+
+        for (int y = 0; y < a.Height(); y++)
+        {
+            for (int x = 0; x < a.Width(); x++)
+            {
+                if (a.Board().Get(x, y) != b.Board().Get(x, y))
+                {
+                    return "cell (" + std::to_string(x) + ", " + std::to_string(y) + ")";
+                }
+            }
+        }
+
+        return {};
+    }
+
+    template <typename Step>
+    double TicksPerSecond(int size, size_t snakes, size_t ticks, const Step& step)
+    {
+        Arena arena(size, size, 7);
+        Populate(arena, snakes);
+        uint64_t random = 2;
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t tick = 0; tick < ticks && arena.Alive() > 0; tick++)
+        {
+            Steer(arena, random);
+            step(arena);
+        }
+
+        return double(arena.TickCount()) / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t side = 512;
+    uint64_t snakes = 2000;
+    uint64_t ticks = 300;
+    uint64_t workers = 8;
+
+    if (argc > 5 || (argc > 1 && !ParseNumber(argv[1], side, false)) || (argc > 2 && !ParseNumber(argv[2], snakes, false)) ||
+        (argc > 3 && !ParseNumber(argv[3], ticks, false)) || (argc > 4 && !ParseNumber(argv[4], workers, false)) ||
+        side < 3 || side > 65536)
+    {
+        std::cerr << "Usage: " << argv[0] << " [size] [snakes] [ticks] [workers]" << std::endl;
+        return 2;
+    }
+
+    auto size = int(side);
+
+    WorkerPool one(1);
+    WorkerPool many(workers);
+    Arena serial(size, size, 7);
+    Arena single(size, size, 7);
+    Arena parallel(size, size, 7);
+    Populate(serial, snakes);
+    Populate(single, snakes);
+    Populate(parallel, snakes);
+    uint64_t random = 2;
+
+    for (size_t tick = 0; tick < ticks && serial.Alive() > 0; tick++)
+    {
+        // Every arena gets the directions the serial one chose
+        Steer(serial, random);
+        for (size_t id = 0; id < serial.SnakeCount(); id++)
+        {
+            single.SetDirection(id, serial.GetDirection(id));
+            parallel.SetDirection(id, serial.GetDirection(id));
+        }
+
+        serial.Tick();
+        single.Tick(one);
+        parallel.Tick(many);
+
+        for (auto* arena : {&single, &parallel})
+        {
+            auto difference = Compare(serial, *arena);
+
+            if (!difference.empty())
+            {
+                std::cout << "tick " << tick << ": " << (arena == &single ? "1 worker" : std::to_string(workers) + " workers")
+                          << " differs from the serial tick: " << difference << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    std::cout << serial.SnakeCount() << " snakes agree for " << serial.TickCount() << " ticks" << std::endl;
+    std::cout << "serial: " << TicksPerSecond(size, snakes, ticks, [](Arena& arena) { arena.Tick(); }) << " ticks/s" << std::endl;
+
+    for (size_t n = 1; n <= workers; n *= 2)
+    {
+        WorkerPool pool(n);
+        std::cout << n << " workers: " << TicksPerSecond(size, snakes, ticks, [&pool](Arena& arena) { arena.Tick(pool); }) << " ticks/s" << std::endl;
+    }
+
+    return 0;
+}
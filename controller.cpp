@@ -0,0 +1,45 @@
+#include "ControlChannel.hpp"
+#include "Hamiltonian.hpp"
+
+#include <iostream>
+
+// Steers a game started with SNAKE_CONTROL=<name> from outside its process, and
+// gives up on a game that has stopped publishing
+int main(int argc, char** argv)
+{
+    constexpr int MaxTimeouts = 5;
+
+    try
+    {
+        std::string name = argc > 1 ? argv[1] : "/snake";
+        ControlChannel<256 / 3, 240 / 3> channel(name, ControlChannel<256 / 3, 240 / 3>::Mode::Open);
+        Game<256 / 3, 240 / 3> game;
+        bool alive = true;
+        auto seen = channel.Read(game, alive);
+
+        while (alive)
+        {
+            channel.Send(Hamiltonian<256 / 3, 240 / 3>::Steer(game));
+
+            int timeouts = 0;
+            while (!channel.Wait(seen, std::chrono::milliseconds(1000)))
+            {
+                if (++timeouts == MaxTimeouts)
+                {
+                    std::cerr << "The game has not published for " << MaxTimeouts << " s; giving up" << std::endl;
+                    return 1;
+                }
+            }
+
+            seen = channel.Read(game, alive);
+        }
+
+        std::cout << "Game over after " << game.TickCount() << " ticks with a score of " << game.Score() << std::endl;
+        return 0;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,131 @@
+#include "Arguments.hpp"
+#include "Autopilot.hpp"
+#include "Dataset.hpp"
+#include "Game.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Records seeded games played by the autopilot as training data, or describes a
+// shard of it, decoding every plane on the way.
+//
+//   SnakeDataset <prefix> [games] [ticks] [first seed]
+//   SnakeDataset --read <shard>
+
+using DatasetGame = Game<256 / 3, 240 / 3>;
+
+namespace
+{
+    double Seconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    int Record(const std::string& prefix, uint64_t games, size_t ticks, uint64_t first)
+    {
+        Dataset::Writer<DatasetGame::Width(), DatasetGame::Height()> writer(prefix);
+        Autopilot<DatasetGame::Width(), DatasetGame::Height()> autopilot(std::chrono::microseconds(50));
+        DatasetGame game;
+        size_t rows = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        for (auto seed = first; seed < first + games; seed++)
+        {
+            game.Reset(seed);
+            autopilot.Attach(game);
+
+            for (size_t tick = 0; tick < ticks; tick++)
+            {
+                writer.Observe(game, uint32_t(seed));
+
+                if (tick > 0)
+                {
+                    autopilot.Update(game);
+                }
+
+                auto action = autopilot.Steer(game);
+                auto score = game.Score();
+                game.SetDirection(action);
+                auto alive = game.TryTick();
+
+                writer.Outcome(action, int32_t(game.Score() - score), !alive);
+                rows++;
+
+                if (!alive)
+                {
+                    break;
+                }
+            }
+        }
+
+        writer.Close();
+        std::cout << rows << " rows in " << writer.Shards() << " shards in " << Seconds(start) << " s" << std::endl;
+        return 0;
+    }
+
+    int Read(const std::string& path)
+    {
+        Dataset::Shard shard(path);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<uint8_t> planes(shard.Rows() * shard.PlaneBytes());
+        size_t cells[Dataset::Planes] = {};
+
+        for (size_t p = 0; p < Dataset::Planes; p++)
+        {
+            shard.Read(Dataset::Plane(p), 0, shard.Rows(), planes.data());
+
+            for (auto byte : planes)
+            {
+                cells[p] += size_t(__builtin_popcount(byte));
+            }
+        }
+
+        size_t games = 0;
+        int64_t reward = 0;
+
+        for (size_t n = 0; n < shard.Rows(); n++)
+        {
+            games += n == 0 || shard.Games()[n] != shard.Games()[n - 1];
+            reward += shard.Rewards()[n];
+        }
+
+        auto rows = double(shard.Rows());
+        std::cout << shard.Width() << "x" << shard.Height() << ", " << shard.Rows() << " rows from " << games
+                  << " games, reward " << reward << ", decoded in " << Seconds(start) << " s" << std::endl
+                  << "mean cells a row: walls " << cells[0] / rows << ", body " << cells[1] / rows
+                  << ", good " << cells[2] / rows << ", bad " << cells[3] / rows << std::endl;
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc == 3 && std::string(argv[1]) == "--read")
+        {
+            return Read(argv[2]);
+        }
+
+        uint64_t games = 100;
+        uint64_t ticks = 5000;
+        uint64_t first = 1;
+
+        // A recording of nothing would look like one that worked
+        if (argc < 2 || argc > 5 || argv[1][0] == '-' || (argc > 2 && !ParseNumber(argv[2], games, false)) ||
+            (argc > 3 && !ParseNumber(argv[3], ticks, false)) || (argc > 4 && !ParseNumber(argv[4], first, true)))
+        {
+            std::cerr << "Usage: " << argv[0] << " <prefix> [games] [ticks] [first seed] | --read <shard>" << std::endl;
+            return 2;
+        }
+
+        return Record(argv[1], games, ticks, first);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,280 @@
+#include "Arguments.hpp"
+#include "DeltaStream.hpp"
+#include "Game.hpp"
+#include "Hamiltonian.hpp"
+#include "ReferenceGame.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Plays Game and ReferenceGame side by side from the same seeds with the same
+// turns, and compares a hash of everything either of them can show after every
+// tick. The board is small so that long games fill it, which is where obstacles
+// have to search for a free cell. Game is reset in place from one game to the next,
+// so what a restart leaves behind shows up too. Every tick is also sent through a
+// DeltaStream, and what the decoder rebuilds is held to the same hash, after it
+// has refused a spoiled copy of the frame. Stops at the first tick anything
+// disagrees.
+//
+//   SnakeDiffTest [games] [ticks] [first seed]
+
+constexpr int Width = 24;
+constexpr int Height = 20;
+
+using FastGame = Game<Width, Height>;
+using SlowGame = ReferenceGame<Width, Height>;
+
+namespace
+{
+    uint64_t NextRandom(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t Mix(uint64_t hash, uint64_t value)
+    {
+        return NextRandom(hash += value);
+    }
+
+    uint64_t ObstacleKey(const Coordinates& c, bool bad)
+    {
+        uint64_t state = uint64_t(c.second * Width + c.first) * 2 + bad;
+        return NextRandom(state);
+    }
+
+    // The body in order from the head, the obstacles in any order, and the rest
+    template <typename T>
+    uint64_t StateHash(const T& game, bool alive)
+    {
+        uint64_t hash = 0;
+
+        for (size_t n = 0; n < game.Length(); n++)
+        {
+            auto c = game.Body(n);
+            hash = Mix(hash, uint64_t(c.second * Width + c.first));
+        }
+
+        uint64_t obstacles = 0;
+        for (size_t n = 0; n < game.ObstacleCount(); n++)
+        {
+            obstacles += ObstacleKey(game.Obstacle(n), game.IsBad(game.Obstacle(n)));
+        }
+
+        hash = Mix(hash, obstacles);
+        hash = Mix(hash, game.ObstacleCount());
+        hash = Mix(hash, uint64_t(game.GetDirection()));
+        hash = Mix(hash, game.TickCount());
+        hash = Mix(hash, game.Score());
+        hash = Mix(hash, game.PendingGrowth());
+        return Mix(hash, alive);
+    }
+
+    bool IsBadObstacle(const FastGame& game, size_t n)
+    {
+        return game.IsBad(game.Obstacle(n));
+    }
+
+    bool IsBadObstacle(const DeltaStream::Decoder<Width, Height>& decoder, size_t n)
+    {
+        return decoder.IsBad(n);
+    }
+
+    // What a stream carries: the body in order, the obstacles in any order, the
+    // tick, the score and whether the snake is alive
+    template <typename T>
+    uint64_t StreamHash(const T& game, bool alive)
+    {
+        uint64_t hash = 0;
+
+        for (size_t n = 0; n < game.Length(); n++)
+        {
+            auto c = game.Body(n);
+            hash = Mix(hash, uint64_t(c.second * Width + c.first));
+        }
+
+        uint64_t obstacles = 0;
+        for (size_t n = 0; n < game.ObstacleCount(); n++)
+        {
+            obstacles += ObstacleKey(game.Obstacle(n), IsBadObstacle(game, n));
+        }
+
+        hash = Mix(hash, obstacles);
+        hash = Mix(hash, game.ObstacleCount());
+        hash = Mix(hash, game.TickCount());
+        hash = Mix(hash, game.Score());
+        return Mix(hash, alive);
+    }
+
+    std::string Describe(const FastGame& fast, const SlowGame& slow)
+    {
+        auto head = [](const Coordinates& c) { return "(" + std::to_string(c.first) + ", " + std::to_string(c.second) + ")"; };
+
+        return "length " + std::to_string(fast.Length()) + " / " + std::to_string(slow.Length()) +
+               ", head " + head(fast.Body(0)) + " / " + head(slow.Body(0)) +
+               ", obstacles " + std::to_string(fast.ObstacleCount()) + " / " + std::to_string(slow.ObstacleCount()) +
+               ", score " + std::to_string(fast.Score()) + " / " + std::to_string(slow.Score()) +
+               ", growth " + std::to_string(fast.PendingGrowth()) + " / " + std::to_string(slow.PendingGrowth());
+    }
+
+    Coordinates Neighbour(const Coordinates& c, Direction direction)
+    {
+        switch (direction)
+        {
+            case Direction::North: return {c.first, c.second - 1};
+            case Direction::East:  return {c.first + 1, c.second};
+            case Direction::South: return {c.first, c.second + 1};
+            case Direction::West:  return {c.first - 1, c.second};
+        }
+
+        return c;
+    }
+
+    // Every third game follows the Hamiltonian pilot, straying now and then onto a
+    // free cell, so it grows over much of the board; the rest turn at random
+    Direction Choose(const FastGame& game, uint64_t seed, uint64_t& random)
+    {
+        auto r = NextRandom(random);
+
+        if (seed % 3 == 0)
+        {
+            auto stray = Direction(r >> 8 & 3);
+            return r % 64 == 0 && !game.IsBlocked(Neighbour(game.Head(), stray)) ? stray : Hamiltonian<Width, Height>::Steer(game);
+        }
+
+        return r % 6 == 0 ? Direction(r >> 8 & 3) : game.GetDirection();
+    }
+
+    struct Stream
+    {
+        // Short, so both keyframes and runs of deltas are decoded
+        DeltaStream::Encoder<Width, Height> encoder{16};
+        DeltaStream::Decoder<Width, Height> decoder;
+        std::vector<uint8_t> frame;
+    };
+
+    // A copy of the frame with one cell off the board, or with its last event made
+    // unknown, has to be refused without touching what the decoder holds. Deltas
+    // with no events have nothing to spoil
+    bool RefusesSpoiled(Stream& stream, size_t tick)
+    {
+        auto spoiled = stream.frame;
+
+        if (spoiled[0] == DeltaStream::Keyframe)
+        {
+            // The head, after the tag, tick, alive, score and length
+            spoiled[12] = spoiled[13] = 0xFF;
+        }
+        else if (spoiled[6] == 0)
+        {
+            return true;
+        }
+        else if (tick % 2 == 0)
+        {
+            spoiled[spoiled.size() - 3] = 0xFF;
+        }
+        else
+        {
+            spoiled[spoiled.size() - 2] = spoiled[spoiled.size() - 1] = 0xFF;
+        }
+
+        auto before = StreamHash(stream.decoder, stream.decoder.Alive());
+
+        try
+        {
+            stream.decoder.Decode(spoiled.data(), spoiled.size());
+            return false;
+        }
+        catch (std::runtime_error&)
+        {
+        }
+
+        return StreamHash(stream.decoder, stream.decoder.Alive()) == before;
+    }
+
+    // Returns false and says where if the games part
+    bool Play(FastGame& fast, Stream& stream, uint64_t seed, size_t ticks)
+    {
+        SlowGame slow;
+        fast.Reset(seed);
+        slow.Seed(seed);
+        stream.encoder.RequestKeyframe();
+        uint64_t random = ~seed;
+
+        for (size_t tick = 0; tick < ticks; tick++)
+        {
+            auto direction = Choose(fast, seed, random);
+            fast.SetDirection(direction);
+            slow.SetDirection(direction);
+
+            auto fastAlive = fast.TryTick();
+            auto slowAlive = slow.TryTick();
+
+            if (StateHash(fast, fastAlive) != StateHash(slow, slowAlive))
+            {
+                std::cout << "seed " << seed << " diverges at tick " << tick << ": "
+                          << (fastAlive ? "alive" : "dead") << " / " << (slowAlive ? "alive" : "dead") << ", "
+                          << Describe(fast, slow) << std::endl;
+                return false;
+            }
+
+            stream.frame.clear();
+            stream.encoder.Encode(fast, fastAlive, stream.frame);
+
+            if (stream.decoder.Synced() && !RefusesSpoiled(stream, tick))
+            {
+                std::cout << "seed " << seed << ": a spoiled frame was not refused whole at tick " << tick << std::endl;
+                return false;
+            }
+
+            if (stream.decoder.Decode(stream.frame.data(), stream.frame.size()) != stream.frame.size() ||
+                StreamHash(stream.decoder, stream.decoder.Alive()) != StreamHash(fast, fastAlive))
+            {
+                std::cout << "seed " << seed << ": the delta stream decodes to a different game at tick " << tick
+                          << ": length " << stream.decoder.Length() << " / " << fast.Length()
+                          << ", obstacles " << stream.decoder.ObstacleCount() << " / " << fast.ObstacleCount()
+                          << ", score " << stream.decoder.Score() << " / " << fast.Score() << std::endl;
+                return false;
+            }
+
+            if (!fastAlive)
+            {
+                break;
+            }
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t games = 1000;
+    uint64_t ticks = 5000;
+    uint64_t first = 1;
+
+    // A run that compares nothing would look like one that passed
+    if (argc > 4 || (argc > 1 && !ParseNumber(argv[1], games, false)) || (argc > 2 && !ParseNumber(argv[2], ticks, false)) ||
+        (argc > 3 && !ParseNumber(argv[3], first, true)))
+    {
+        std::cerr << "Usage: " << argv[0] << " [games] [ticks] [first seed]" << std::endl;
+        return 2;
+    }
+
+    FastGame fast;
+    Stream stream;
+
+    for (auto seed = first; seed < first + games; seed++)
+    {
+        if (!Play(fast, stream, seed, ticks))
+        {
+            return 1;
+        }
+    }
+
+    std::cout << games << " games agree" << std::endl;
+    return 0;
+}
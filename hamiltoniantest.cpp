@@ -0,0 +1,117 @@
+#include "Arguments.hpp"
+#include "Game.hpp"
+#include "Hamiltonian.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Plays seeded games with nothing but the Hamiltonian pilot, on a board whose
+// cycle runs along the rows and on one whose cycle runs along the columns. The
+// snake outgrows any board in the end, so every game is played until it dies, and
+// the pilot is held to what it promises: it only dies with the head boxed in, and
+// the median game grows the snake to at least a fifth of the board.
+//
+//   SnakeHamiltonianTest [games]
+
+namespace
+{
+    Coordinates Neighbour(const Coordinates& c, Direction direction)
+    {
+        switch (direction)
+        {
+            case Direction::North: return {c.first, c.second - 1};
+            case Direction::East:  return {c.first + 1, c.second};
+            case Direction::South: return {c.first, c.second + 1};
+            case Direction::West:  return {c.first - 1, c.second};
+        }
+
+        return c;
+    }
+
+    // A move into the tail is open when it moves off as the head moves on
+    template <int width, int height>
+    bool BoxedIn(const Game<width, height>& game)
+    {
+        for (auto direction : {Direction::North, Direction::East, Direction::South, Direction::West})
+        {
+            auto c = Neighbour(game.Head(), direction);
+
+            if (!game.IsBlocked(c) || (c == game.Tail() && game.PendingGrowth() == 0))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Returns what went wrong, or nothing
+    template <int width, int height>
+    std::string Play(uint64_t games)
+    {
+        constexpr size_t Cells = size_t(width - 2) * size_t(height - 2);
+        std::vector<size_t> lengths;
+
+        for (uint64_t seed = 1; seed <= games; seed++)
+        {
+            Game<width, height> game;
+            game.Seed(seed);
+
+            while (true)
+            {
+                game.SetDirection(Hamiltonian<width, height>::Steer(game));
+                bool boxedIn = BoxedIn(game);
+
+                if (!game.TryTick())
+                {
+                    if (!boxedIn)
+                    {
+                        return "seed " + std::to_string(seed) + " died at tick " + std::to_string(game.TickCount()) +
+                               " with a way out";
+                    }
+
+                    break;
+                }
+            }
+
+            lengths.push_back(game.Length());
+        }
+
+        std::sort(lengths.begin(), lengths.end());
+        auto median = lengths[lengths.size() / 2];
+
+        std::cout << width << "x" << height << ": the snake grew to " << lengths.front() << " cells at least, "
+                  << median << " in the median game and " << lengths.back() << " at most, of " << Cells << std::endl;
+
+        if (median * 5 < Cells)
+        {
+            return "the median game grew to only " + std::to_string(median) + " of " + std::to_string(Cells) + " cells";
+        }
+
+        return {};
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t games = 200;
+
+    if (argc > 2 || (argc > 1 && !ParseNumber(argv[1], games, false)))
+    {
+        std::cerr << "Usage: " << argv[0] << " [games]" << std::endl;
+        return 2;
+    }
+
+    for (auto difference : {Play<14, 14>(games), Play<24, 19>(games)})
+    {
+        if (!difference.empty())
+        {
+            std::cout << difference << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
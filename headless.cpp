@@ -0,0 +1,52 @@
+#define OLC_PLATFORM_HEADLESS
+#include "Snake.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+void WriteFrame(const std::string& path, const olc::Sprite* frame)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << "P6\n" << frame->width << " " << frame->height << "\n255\n";
+
+    for (int n = 0; n < frame->width * frame->height; n++)
+    {
+        auto& p = frame->pColData[n];
+        out.put(char(p.r)).put(char(p.g)).put(char(p.b));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+    std::string screenshot = argc > 2 ? argv[2] : "";
+    std::string pilot = argc > 3 ? argv[3] : "autopilot";
+    size_t count = 0;
+
+    Snake<256 / 3, 240 / 3, 4 * 3, 4 * 3> snake;
+    snake.SetPilot(pilot == "hamiltonian" ? Pilot::Hamiltonian : pilot == "mcts" ? Pilot::Mcts : Pilot::Autopilot);
+    snake.SetFrameCallback([&](const olc::Sprite* frame)
+    {
+        count++;
+
+        if (count < frames)
+        {
+            return true;
+        }
+
+        if (!screenshot.empty())
+        {
+            WriteFrame(screenshot, frame);
+        }
+
+        return false;
+    });
+
+    auto start = GetTimeMs();
+    snake.Start();
+    auto elapsed = GetTimeMs() - start;
+
+    std::cout << count << " frames in " << elapsed << " ms" << std::endl;
+    return 0;
+}
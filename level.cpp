@@ -0,0 +1,52 @@
+#include "Level.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Compiles a level drawn in text into the binary format games map, or describes
+// a compiled one.
+//
+//   SnakeLevel <design.txt> <level>
+//   SnakeLevel <level>
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc == 3)
+        {
+            std::ifstream in(argv[1]);
+
+            if (!in)
+            {
+                std::cerr << "Could not read " << argv[1] << std::endl;
+                return 2;
+            }
+
+            Level::Save(Level::Parse(in), argv[2]);
+        }
+        else if (argc != 2)
+        {
+            std::cerr << "Usage: " << argv[0] << " <design.txt> <level> | <level>" << std::endl;
+            return 2;
+        }
+
+        Level level(argv[argc - 1]);
+
+        std::cout << level.Width() << "x" << level.Height() << ", " << level.FreeCount() << " free cells, "
+                  << level.ZoneCount() << " zones, " << level.PortalCount() << " portals" << std::endl;
+
+        for (size_t n = 0; n < level.ZoneCount(); n++)
+        {
+            std::cout << "  zone " << n << ": " << level.ZoneSize(n) << " cells" << std::endl;
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
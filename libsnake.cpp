@@ -0,0 +1,142 @@
+#include "libsnake.h"
+#include "Game.hpp"
+
+#include <new>
+
+struct snake_game
+{
+    Game<SNAKE_WIDTH, SNAKE_HEIGHT> game;
+    bool alive;
+};
+
+namespace
+{
+    void Reset(snake_game& game, uint64_t seed)
+    {
+        game.game.Reset(seed);
+        game.alive = true;
+    }
+
+    snake_outcome Step(snake_game& game, int direction)
+    {
+        if (direction < SNAKE_NORTH || direction > SNAKE_WEST)
+        {
+            return SNAKE_INVALID;
+        }
+
+        if (!game.alive)
+        {
+            return SNAKE_OVER;
+        }
+
+        auto score = game.game.Score();
+        game.game.SetDirection(Direction(direction));
+        game.alive = game.game.TryTick();
+
+        if (!game.alive)
+        {
+            return SNAKE_DIED;
+        }
+
+        return game.game.Score() > score ? SNAKE_ATE : SNAKE_MOVED;
+    }
+
+    void Observe(const snake_game& game, uint8_t* cells)
+    {
+        auto& g = game.game;
+
+        // Walls as the game has them, so a game on a level shows the level's
+        for (int y = 0; y < SNAKE_HEIGHT; y++)
+        {
+            for (int x = 0; x < SNAKE_WIDTH; x++)
+            {
+                cells[y * SNAKE_WIDTH + x] = g.Walls().Test(std::make_pair(x, y)) ? SNAKE_BORDER : SNAKE_EMPTY;
+            }
+        }
+
+        for (size_t n = 0; n < g.ObstacleCount(); n++)
+        {
+            auto c = g.Obstacle(n);
+            cells[c.second * SNAKE_WIDTH + c.first] = g.IsBad(c) ? SNAKE_BAD : SNAKE_GOOD;
+        }
+
+        for (size_t n = g.Length(); n-- > 0;)
+        {
+            auto c = g.Body(n);
+            cells[c.second * SNAKE_WIDTH + c.first] = n == 0 ? SNAKE_HEAD : SNAKE_BODY;
+        }
+    }
+}
+
+snake_game* snake_create(uint64_t seed)
+{
+    auto game = new (std::nothrow) snake_game;
+
+    if (game)
+    {
+        Reset(*game, seed);
+    }
+
+    return game;
+}
+
+void snake_destroy(snake_game* game)
+{
+    delete game;
+}
+
+void snake_reset(snake_game* game, uint64_t seed)
+{
+    Reset(*game, seed);
+}
+
+snake_outcome snake_step(snake_game* game, int direction)
+{
+    return Step(*game, direction);
+}
+
+void snake_step_batch(snake_game* const* games, const int* directions, snake_outcome* outcomes, size_t count)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        outcomes[n] = Step(*games[n], directions[n]);
+    }
+}
+
+void snake_observe(const snake_game* game, uint8_t* cells)
+{
+    Observe(*game, cells);
+}
+
+void snake_observe_batch(const snake_game* const* games, uint8_t* cells, size_t count)
+{
+    for (size_t n = 0; n < count; n++)
+    {
+        Observe(*games[n], cells + n * SNAKE_CELLS);
+    }
+}
+
+int snake_alive(const snake_game* game)
+{
+    return game->alive;
+}
+
+size_t snake_length(const snake_game* game)
+{
+    return game->game.Length();
+}
+
+size_t snake_score(const snake_game* game)
+{
+    return game->game.Score();
+}
+
+size_t snake_ticks(const snake_game* game)
+{
+    return game->game.TickCount();
+}
+
+uint64_t snake_hash(const snake_game* game)
+{
+    return game->game.Hash();
+}
@@ -0,0 +1,88 @@
+#ifndef LIBSNAKE_H
+#define LIBSNAKE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* The library is built with SNAKE_BUILDING defined, and everyone else imports */
+#if defined(_WIN32) && defined(SNAKE_BUILDING)
+#define SNAKE_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define SNAKE_API __declspec(dllimport)
+#else
+#define SNAKE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The simulator without a window, for embedding in other runtimes. Every game is
+   on the same fixed board. Nothing here throws, and only snake_create allocates:
+   stepping and observing use caller-owned memory and take no locks, so separate
+   games can be stepped from separate threads. */
+
+#define SNAKE_WIDTH 85
+#define SNAKE_HEIGHT 80
+#define SNAKE_CELLS (SNAKE_WIDTH * SNAKE_HEIGHT)
+
+typedef struct snake_game snake_game;
+
+typedef enum snake_direction
+{
+    SNAKE_NORTH = 0,
+    SNAKE_EAST = 1,
+    SNAKE_SOUTH = 2,
+    SNAKE_WEST = 3
+} snake_direction;
+
+typedef enum snake_outcome
+{
+    SNAKE_MOVED = 0,
+    SNAKE_ATE = 1,
+    SNAKE_DIED = 2,
+    /* The game was already over; reset it to play again */
+    SNAKE_OVER = 3,
+    SNAKE_INVALID = -1
+} snake_outcome;
+
+/* Cell values written by snake_observe */
+typedef enum snake_cell
+{
+    SNAKE_EMPTY = 0,
+    /* Any wall of the game, which on this board is its border */
+    SNAKE_BORDER = 1,
+    SNAKE_BODY = 2,
+    SNAKE_HEAD = 3,
+    SNAKE_GOOD = 4,
+    SNAKE_BAD = 5
+} snake_cell;
+
+/* Returns NULL if memory runs out */
+SNAKE_API snake_game* snake_create(uint64_t seed);
+SNAKE_API void snake_destroy(snake_game* game);
+SNAKE_API void snake_reset(snake_game* game, uint64_t seed);
+
+/* Turns to direction, then moves one tick */
+SNAKE_API snake_outcome snake_step(snake_game* game, int direction);
+
+/* Steps games[n] with directions[n] and writes outcomes[n], for n below count */
+SNAKE_API void snake_step_batch(snake_game* const* games, const int* directions, snake_outcome* outcomes, size_t count);
+
+/* Writes SNAKE_CELLS snake_cell values, row by row, into cells */
+SNAKE_API void snake_observe(const snake_game* game, uint8_t* cells);
+
+/* As snake_observe for every game, with game n at cells + n * SNAKE_CELLS */
+SNAKE_API void snake_observe_batch(const snake_game* const* games, uint8_t* cells, size_t count);
+
+SNAKE_API int snake_alive(const snake_game* game);
+SNAKE_API size_t snake_length(const snake_game* game);
+SNAKE_API size_t snake_score(const snake_game* game);
+SNAKE_API size_t snake_ticks(const snake_game* game);
+SNAKE_API uint64_t snake_hash(const snake_game* game);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
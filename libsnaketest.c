@@ -0,0 +1,226 @@
+#include "libsnake.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Uses libsnake the way an embedding runtime would, from plain C99 against the
+   public header and the shared library: games from the same seed play alike and
+   reset to the same start, observations show the walls and one head, batches
+   match single steps, and bad directions and finished games are reported rather
+   than played.
+
+     SnakeLibTest [games] [ticks] */
+
+static int failures = 0;
+static size_t meals = 0;
+
+static void expect(int condition, const char* what)
+{
+    if (!condition)
+    {
+        printf("%s\n", what);
+        failures++;
+    }
+}
+
+static uint64_t next_random(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* Mostly straight on, turning now and then, and never into a cell the observation
+   shows taken while one is free, so games last long enough to eat */
+static int choose(const uint8_t* cells, uint64_t* random, int last)
+{
+    static const int dx[4] = {0, 1, 0, -1};
+    static const int dy[4] = {-1, 0, 1, 0};
+    uint64_t r = next_random(random);
+    int first = r % 8 == 0 ? (int)(r >> 8 & 3) : last;
+    int head = 0;
+    int n;
+
+    while (head < SNAKE_CELLS - 1 && cells[head] != SNAKE_HEAD)
+    {
+        head++;
+    }
+
+    for (n = 0; n < 4; n++)
+    {
+        int direction = (first + n) % 4;
+        int x = head % SNAKE_WIDTH + dx[direction];
+        int y = head / SNAKE_WIDTH + dy[direction];
+        uint8_t cell = cells[y * SNAKE_WIDTH + x];
+
+        if (cell == SNAKE_EMPTY || cell == SNAKE_GOOD)
+        {
+            return direction;
+        }
+    }
+
+    return first;
+}
+
+/* Only plain decimal numbers above zero */
+static int parse_count(const char* text, unsigned long* value)
+{
+    char* end;
+
+    if (*text < '0' || *text > '9')
+    {
+        return 0;
+    }
+
+    errno = 0;
+    *value = strtoul(text, &end, 10);
+    return *end == 0 && errno == 0 && *value > 0;
+}
+
+static void check_observation(const snake_game* game, const uint8_t* cells)
+{
+    size_t heads = 0;
+    size_t body = 0;
+    int x;
+    int y;
+
+    for (y = 0; y < SNAKE_HEIGHT; y++)
+    {
+        for (x = 0; x < SNAKE_WIDTH; x++)
+        {
+            uint8_t cell = cells[y * SNAKE_WIDTH + x];
+            int border = x == 0 || y == 0 || x == SNAKE_WIDTH - 1 || y == SNAKE_HEIGHT - 1;
+
+            if (border && cell != SNAKE_BORDER && cell != SNAKE_HEAD)
+            {
+                expect(0, "A border cell is not observed as a wall");
+                return;
+            }
+
+            if (!border && cell == SNAKE_BORDER)
+            {
+                expect(0, "An inside cell is observed as a wall");
+                return;
+            }
+
+            heads += cell == SNAKE_HEAD;
+            body += cell == SNAKE_BODY;
+        }
+    }
+
+    expect(heads == 1, "The observation does not show one head");
+
+    /* Parts of the body can share a cell while it grows, so it is never more */
+    expect(body + heads <= snake_length(game), "The observation shows more body than the snake has");
+}
+
+static void play(uint64_t seed, size_t ticks)
+{
+    snake_game* a = snake_create(seed);
+    snake_game* b = snake_create(seed);
+    uint8_t* cells = malloc(2 * SNAKE_CELLS);
+    uint64_t random = seed;
+    int direction = SNAKE_NORTH;
+    size_t eaten = 0;
+    size_t tick;
+
+    if (!a || !b || !cells)
+    {
+        expect(0, "Out of memory");
+        snake_destroy(a);
+        snake_destroy(b);
+        free(cells);
+        return;
+    }
+
+    expect(snake_alive(a) && snake_ticks(a) == 0 && snake_score(a) == 0, "A new game is not at its start");
+    expect(snake_hash(a) == snake_hash(b), "Games from the same seed start apart");
+
+    for (tick = 0; tick < ticks && snake_alive(a); tick++)
+    {
+        snake_game* games[2];
+        int directions[2];
+        snake_outcome outcomes[2];
+        size_t score = snake_score(a);
+        snake_outcome outcome;
+
+        snake_observe(a, cells);
+        check_observation(a, cells);
+        direction = choose(cells, &random, direction);
+        outcome = snake_step(a, direction);
+        eaten += outcome == SNAKE_ATE;
+
+        games[0] = b;
+        games[1] = b;
+        directions[0] = direction;
+        directions[1] = 7;
+        snake_step_batch(games, directions, outcomes, 2);
+
+        expect(outcome == outcomes[0], "A batched step has another outcome than a single one");
+        expect(outcomes[1] == SNAKE_INVALID, "A bad direction was played");
+        expect(snake_hash(a) == snake_hash(b), "A batched step plays another game than a single one");
+        expect(outcome != SNAKE_ATE || snake_score(a) == score + 1, "Eating did not score");
+        expect((outcome == SNAKE_DIED) == !snake_alive(a), "A death was not reported");
+
+        games[0] = a;
+        games[1] = b;
+        snake_observe_batch((const snake_game* const*)games, cells, 2);
+        expect(memcmp(cells, cells + SNAKE_CELLS, SNAKE_CELLS) == 0, "Batched observations differ for equal games");
+
+        if (failures)
+        {
+            break;
+        }
+    }
+
+    expect(eaten == snake_score(a), "Not every point was reported as eating");
+    meals += eaten;
+
+    if (!snake_alive(a))
+    {
+        expect(snake_step(a, SNAKE_NORTH) == SNAKE_OVER, "A finished game was stepped");
+    }
+
+    /* A reset game is the seed's new game, whatever it played before */
+    snake_destroy(b);
+    b = snake_create(seed);
+    snake_reset(a, seed);
+    expect(b && snake_alive(a) && snake_ticks(a) == 0, "Reset did not start a new game");
+    expect(b && snake_hash(a) == snake_hash(b), "Reset did not start the seed's game");
+
+    snake_destroy(a);
+    snake_destroy(b);
+    free(cells);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long games = 20;
+    unsigned long ticks = 2000;
+    unsigned long seed;
+
+    if (argc > 3 || (argc > 1 && !parse_count(argv[1], &games)) || (argc > 2 && !parse_count(argv[2], &ticks)))
+    {
+        fprintf(stderr, "Usage: %s [games] [ticks]\n", argv[0]);
+        return 2;
+    }
+
+    for (seed = 1; seed <= games && !failures; seed++)
+    {
+        play(seed, ticks);
+    }
+
+    /* Twenty games eat about ten times; fewer games may not eat at all */
+    expect(meals > 0 || games < 20, "No game ate, so eating went unchecked");
+
+    if (failures)
+    {
+        return 1;
+    }
+
+    printf("%lu games agree through the C API\n", games);
+    return 0;
+}
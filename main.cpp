@@ -1,7 +1,41 @@
 #include "Snake.hpp"
 
+#include <cstdlib>
+
 int main()
 {
     Snake<256 / 3, 240 / 3, 4 * 3, 4 * 3> snake;
+
+    if (auto level = std::getenv("SNAKE_LEVEL"))
+    {
+        snake.LoadLevel(level);
+    }
+
+    if (std::getenv("SNAKE_ENDLESS"))
+    {
+        snake.EnableEndless();
+    }
+
+    if (std::getenv("SNAKE_KIOSK"))
+    {
+        snake.EnableKiosk();
+    }
+
+    if (auto scores = std::getenv("SNAKE_SCORES"))
+    {
+        snake.EnableScores(scores);
+    }
+
+    if (auto capture = std::getenv("SNAKE_CAPTURE"))
+    {
+        snake.StartCapture(capture);
+    }
+
+    if (auto control = std::getenv("SNAKE_CONTROL"))
+    {
+        snake.EnableControl(control);
+    }
+
+    snake.Start();
     return 0;
 }
@@ -316,7 +316,7 @@ int main()
 // O------------------------------------------------------------------------------O
 
 // Platform
-#if !defined(OLC_PLATFORM_WINAPI) && !defined(OLC_PLATFORM_X11) && !defined(OLC_PLATFORM_GLUT)
+#if !defined(OLC_PLATFORM_WINAPI) && !defined(OLC_PLATFORM_X11) && !defined(OLC_PLATFORM_GLUT) && !defined(OLC_PLATFORM_HEADLESS)
 	#if defined(_WIN32)
 		#define OLC_PLATFORM_WINAPI
 	#endif
@@ -329,7 +329,11 @@ int main()
 #endif
 
 // Renderer
-#if !defined(OLC_GFX_OPENGL10) || !defined(OLC_GFX_OPENGL33) && !defined(OLC_GFX_DIRECTX10)
+#if defined(OLC_PLATFORM_HEADLESS) && !defined(OLC_GFX_HEADLESS)
+	#define OLC_GFX_HEADLESS
+#endif
+
+#if !defined(OLC_GFX_HEADLESS) && (!defined(OLC_GFX_OPENGL10) || !defined(OLC_GFX_OPENGL33) && !defined(OLC_GFX_DIRECTX10))
 	#define OLC_GFX_OPENGL10
 #endif
 
@@ -550,6 +554,35 @@ namespace olc
 
 
 
+	// O------------------------------------------------------------------------------O
+	// | olc::InputEvent - A timestamped key or mouse event, kept in arrival order    |
+	// O------------------------------------------------------------------------------O
+	struct InputEvent
+	{
+		enum Type : uint8_t { KEY_DOWN, KEY_UP, MOUSE_DOWN, MOUSE_UP, MOUSE_MOVE, MOUSE_WHEEL };
+		Type type = KEY_DOWN;
+		int32_t nCode = 0;			// olc::Key, mouse button or wheel delta
+		olc::vi2d vPos = { 0, 0 };	// Mouse position in "pixel" space
+		std::chrono::time_point<std::chrono::system_clock> tp;
+	};
+
+	// Single producer (platform) / single consumer (engine) ring, never locks or allocates
+	class InputQueue
+	{
+	public:
+		static constexpr uint32_t nCapacity = 4096;
+		bool Push(const olc::InputEvent& e);
+		bool Pop(olc::InputEvent& e);
+		uint32_t Size() const;
+
+	private:
+		std::array<olc::InputEvent, nCapacity> vEvents;
+		std::atomic<uint32_t> nHead{ 0 };
+		std::atomic<uint32_t> nTail{ 0 };
+	};
+
+
+
 	// O------------------------------------------------------------------------------O
 	// | olc::ResourcePack - A virtual scrambled filesystem to pack your assets into  |
 	// O------------------------------------------------------------------------------O
@@ -706,6 +739,69 @@ namespace olc
 		std::function<void()> funcHook = nullptr;
 	};
 
+	// O------------------------------------------------------------------------------O
+	// | olc::FrameCapture - Streams layer frames to disk from a background thread    |
+	// O------------------------------------------------------------------------------O
+	enum class CaptureFormat
+	{
+		RAW_RGBA,	// 24 byte header ("OLCRGBA", w, h, fps) then w*h*4 bytes per frame
+		Y4M,		// YUV4MPEG2, 4:4:4, plays in ffplay/mpv
+	};
+
+	enum class CapturePolicy
+	{
+		DROP,		// Discard the frame if the writer has fallen behind
+		BLOCK,		// Wait for the writer to free a slot
+	};
+
+	struct CaptureStats
+	{
+		uint64_t nCaptured = 0;
+		uint64_t nWritten = 0;
+		uint64_t nDropped = 0;
+	};
+
+	class FrameCapture
+	{
+	public:
+		FrameCapture() = default;
+		~FrameCapture();
+
+	public:
+		olc::rcode Start(const std::string& sFile, const olc::vi2d& vSize, olc::CaptureFormat format,
+			olc::CapturePolicy policy, uint32_t nSlots, uint32_t nFPS);
+		void Stop();
+		bool IsActive() const;
+		// Copies the visible layers into the ring, one memcpy per layer
+		void Push(const std::vector<LayerDesc>& vLayers);
+		olc::CaptureStats GetStats() const;
+
+	private:
+		struct sSlot
+		{
+			uint32_t nLayers = 0;
+			std::vector<olc::Pixel> vData;
+			std::vector<olc::Pixel> vTint;
+		};
+
+		void WriterThread();
+		void Compose(const sSlot& slot);
+		void Write();
+
+		std::vector<sSlot> vSlots;
+		std::atomic<uint64_t> nHead{ 0 };
+		std::atomic<uint64_t> nTail{ 0 };
+		std::atomic<uint64_t> nDropped{ 0 };
+		std::atomic<bool> bActive{ false };
+		olc::vi2d vSize = { 0, 0 };
+		olc::CaptureFormat nFormat = olc::CaptureFormat::Y4M;
+		olc::CapturePolicy nPolicy = olc::CapturePolicy::DROP;
+		std::ofstream ofs;
+		std::thread tWriter;
+		std::vector<olc::Pixel> vFrame;
+		std::vector<uint8_t> vOut;
+	};
+
 	class Renderer
 	{
 	public:
@@ -745,9 +841,31 @@ namespace olc
 
 	
 
+	// Platform key codes to olc::Key. Windows virtual keys, GLUT keys and Latin-1 X11
+	// keysyms fit below 0x100, and the remaining X11 keysyms in use live in 0xFF00-0xFFFF,
+	// so both fold into one flat table. Lookups never allocate, unknown codes give NONE
+	class KeyMap
+	{
+	public:
+		static constexpr size_t nSize = 0x200;
+
+		uint8_t& operator[](size_t nCode)
+		{ return vMap[Slot(nCode)]; }
+
+		uint8_t Find(size_t nCode) const
+		{ size_t i = Slot(nCode); return i < nSize ? vMap[i] : 0; }
+
+	private:
+		static constexpr size_t Slot(size_t nCode)
+		{ return nCode < 0x100 ? nCode : (nCode & ~size_t(0xFF)) == 0xFF00 ? 0x100 | (nCode & 0xFF) : nSize; }
+
+		// One spare entry soaks up writes for codes outside the table
+		std::array<uint8_t, nSize + 1> vMap = { 0 };
+	};
+
 	static std::unique_ptr<Renderer> renderer;
 	static std::unique_ptr<Platform> platform;
-	static std::map<size_t, uint8_t> mapKeys;
+	static olc::KeyMap mapKeys;
 
 	// O------------------------------------------------------------------------------O
 	// | olc::PixelGameEngine - The main BASE class for your application              |
@@ -758,8 +876,14 @@ namespace olc
 		PixelGameEngine();
 		virtual ~PixelGameEngine();
 	public:
+		// With threaded set, OnUserUpdate runs on its own thread and hands finished
+		// layers to the presenting thread through a triple buffer. Graphics resources
+		// (decals, layers, SetScreenSize) must then be created in OnUserCreate. The
+		// presenting thread keeps the window too, so it handles the platform's events
+		// and sets the title; input reaches OnUserUpdate through the input queue.
+		// GLUT drives the engine from its own loop and ignores threaded
 		olc::rcode Construct(int32_t screen_w, int32_t screen_h, int32_t pixel_w, int32_t pixel_h,
-			bool full_screen = false, bool vsync = false, bool cohesion = false);
+			bool full_screen = false, bool vsync = false, bool cohesion = false, bool threaded = false);
 		olc::rcode Start();
 
 	public: // User Override Interfaces
@@ -787,6 +911,9 @@ namespace olc
 		const olc::vi2d& GetWindowMouse() const;
 		// Gets the mouse as a vector to keep Tarriest happy
 		const olc::vi2d& GetMousePos() const;
+		// Every key and mouse event since the previous frame, oldest first. Unlike
+		// GetKey(), a press and release within the same frame are both reported
+		const std::vector<olc::InputEvent>& GetInputEvents() const;
 
 	public: // Utility
 		// Returns the width of the screen in "pixels"
@@ -814,6 +941,17 @@ namespace olc
 		const olc::vi2d& GetPixelSize() const;
 		// Gets actual pixel scale
 		const olc::vi2d& GetScreenPixelSize() const;
+		// Receives every composited frame from renderers that draw into memory
+		// (OLC_GFX_HEADLESS), return false from the callback to stop the engine
+		void SetFrameCallback(std::function<bool(const olc::Sprite*)> f);
+
+	public: // Capture
+		// Streams the layers of every frame to a file from a background thread, costing
+		// the engine one copy per visible layer. Decals and custom layer hooks are not captured
+		olc::rcode StartCapture(const std::string& sFile, olc::CaptureFormat format = olc::CaptureFormat::Y4M,
+			olc::CapturePolicy policy = olc::CapturePolicy::DROP, uint32_t nSlots = 64, uint32_t nFPS = 60);
+		void StopCapture();
+		olc::CaptureStats GetCaptureStats() const;
 
 	public: // CONFIGURATION ROUTINES
 		// Layer targeting functions
@@ -933,14 +1071,13 @@ namespace olc
 		int32_t		nMouseWheelDelta = 0;
 		olc::vi2d	vMousePosCache = { 0, 0 };
 		olc::vi2d   vMouseWindowPos = { 0, 0 };
-		int32_t		nMouseWheelDeltaCache = 0;
 		olc::vi2d	vWindowSize = { 0, 0 };
 		olc::vi2d	vViewPos = { 0, 0 };
 		olc::vi2d	vViewSize = { 0,0 };
 		bool		bFullScreen = false;
 		olc::vf2d	vPixel = { 1.0f, 1.0f };
-		bool		bHasInputFocus = false;
-		bool		bHasMouseFocus = false;
+		std::atomic<bool> bHasInputFocus{ false };
+		std::atomic<bool> bHasMouseFocus{ false };
 		bool		bEnableVSYNC = false;
 		float		fFrameTimer = 1.0f;
 		float		fLastElapsed = 0.0f;
@@ -956,11 +1093,34 @@ namespace olc
 		std::function<olc::Pixel(const int x, const int y, const olc::Pixel&, const olc::Pixel&)> funcPixelMode;
 		std::chrono::time_point<std::chrono::system_clock> m_tp1, m_tp2;
 		std::vector<olc::vi2d> vFontSpacing;
+		std::function<bool(const olc::Sprite*)> funcFrameCallback = nullptr;
+		olc::FrameCapture frameCapture;
+
+		// Frames in flight between the simulation and presentation threads
+		struct LayerFrame
+		{
+			std::vector<LayerDesc> vLayers;
+			std::vector<std::unique_ptr<olc::Sprite>> vSprites;
+		};
+		bool        bThreadedPresent = false;
+		std::array<LayerFrame, 3> vLayerFrames;
+		uint8_t     nBackFrame = 0;
+		uint8_t     nFrontFrame = 1;
+		std::atomic<uint8_t> nSharedFrame{ 2 };
+		// Frames counted in the last second, for the presenter to put in the title
+		std::atomic<uint32_t> nTitleFPS{ 0 };
 
 		// State of keyboard		
 		bool		pKeyNewState[256] = { 0 };
 		bool		pKeyOldState[256] = { 0 };
 		HWButton	pKeyboardState[256] = { 0 };
+		bool		pKeyTouched[256] = { 0 };
+		std::vector<uint8_t> vKeysTouched;
+		std::vector<uint8_t> vKeysChanged;
+
+		// Input events, filled by the platform and drained once per frame
+		olc::InputQueue inputQueue;
+		std::vector<olc::InputEvent> vInputEvents;
 
 		// State of mouse
 		bool		pMouseNewState[nMouseButtons] = { 0 };
@@ -981,17 +1141,27 @@ namespace olc
 	public:
 		// "Break In" Functions
 		void olc_UpdateMouse(int32_t x, int32_t y);
+		void olc_UpdateMouse(int32_t x, int32_t y, const std::chrono::time_point<std::chrono::system_clock>& tp);
 		void olc_UpdateMouseWheel(int32_t delta);
+		void olc_UpdateMouseWheel(int32_t delta, const std::chrono::time_point<std::chrono::system_clock>& tp);
 		void olc_UpdateWindowSize(int32_t x, int32_t y);
 		void olc_UpdateViewport();
 		void olc_ConstructFontSheet();
 		void olc_CoreUpdate();
+		void olc_CoreSimulate();
+		void olc_RenderLayers(std::vector<LayerDesc>& layers, const olc::vi2d& viewPos, const olc::vi2d& viewSize);
+		void olc_PublishLayers();
+		bool olc_PresentLayers();
 		void olc_PrepareEngine();
+		void olc_UpdateTitle(uint32_t fps);
 		void olc_UpdateMouseState(int32_t button, bool state);
+		void olc_UpdateMouseState(int32_t button, bool state, const std::chrono::time_point<std::chrono::system_clock>& tp);
 		void olc_UpdateKeyState(int32_t key, bool state);
+		void olc_UpdateKeyState(int32_t key, bool state, const std::chrono::time_point<std::chrono::system_clock>& tp);
 		void olc_UpdateMouseFocus(bool state);
 		void olc_UpdateKeyFocus(bool state);
 		void olc_Terminate();
+		void olc_FrameComposited(const olc::Sprite* frame);
 
 		// NOTE: Items Here are to be deprecated, I have left them in for now
 		// in case you are using them, but they will be removed.
@@ -1562,6 +1732,214 @@ namespace olc
 		return o;
 	};
 
+	// O------------------------------------------------------------------------------O
+	// | olc::InputQueue IMPLEMENTATION                                               |
+	// O------------------------------------------------------------------------------O
+	bool InputQueue::Push(const olc::InputEvent& e)
+	{
+		const uint32_t nPos = nHead.load(std::memory_order_relaxed);
+		if (nPos - nTail.load(std::memory_order_acquire) >= nCapacity) return false;
+		vEvents[nPos % nCapacity] = e;
+		nHead.store(nPos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool InputQueue::Pop(olc::InputEvent& e)
+	{
+		const uint32_t nPos = nTail.load(std::memory_order_relaxed);
+		if (nPos == nHead.load(std::memory_order_acquire)) return false;
+		e = vEvents[nPos % nCapacity];
+		nTail.store(nPos + 1, std::memory_order_release);
+		return true;
+	}
+
+	uint32_t InputQueue::Size() const
+	{ return nHead.load(std::memory_order_acquire) - nTail.load(std::memory_order_acquire); }
+
+	// O------------------------------------------------------------------------------O
+	// | olc::FrameCapture IMPLEMENTATION                                             |
+	// O------------------------------------------------------------------------------O
+	FrameCapture::~FrameCapture()
+	{
+		Stop();
+	}
+
+	olc::rcode FrameCapture::Start(const std::string& sFile, const olc::vi2d& size, olc::CaptureFormat format,
+		olc::CapturePolicy policy, uint32_t nSlots, uint32_t nFPS)
+	{
+		Stop();
+		if (size.x <= 0 || size.y <= 0 || nSlots == 0) return olc::FAIL;
+
+		ofs.open(sFile, std::ofstream::binary | std::ofstream::trunc);
+		if (!ofs.is_open()) return olc::FAIL;
+
+		vSize = size;
+		nFormat = format;
+		nPolicy = policy;
+		nHead = 0; nTail = 0; nDropped = 0;
+
+		// Allocate everything up front so Push() never has to
+		vSlots = std::vector<sSlot>(nSlots);
+		for (auto& slot : vSlots)
+		{
+			slot.vData.resize(size_t(vSize.x) * size_t(vSize.y));
+			slot.vTint.reserve(8);
+		}
+		vFrame.resize(size_t(vSize.x) * size_t(vSize.y));
+		vOut.resize(vFrame.size() * 4);
+
+		if (nFormat == olc::CaptureFormat::Y4M)
+		{
+			ofs << "YUV4MPEG2 W" << vSize.x << " H" << vSize.y << " F" << nFPS << ":1 Ip A1:1 C444\n";
+		}
+		else
+		{
+			uint32_t header[6] = { 0x52434C4F, 0x00414247, uint32_t(vSize.x), uint32_t(vSize.y), nFPS, 0 }; // "OLCRGBA\0"
+			ofs.write((const char*)header, sizeof(header));
+		}
+
+		bActive = true;
+		tWriter = std::thread(&FrameCapture::WriterThread, this);
+		return olc::OK;
+	}
+
+	void FrameCapture::Stop()
+	{
+		bActive = false;
+		if (tWriter.joinable()) tWriter.join();
+		if (ofs.is_open()) ofs.close();
+	}
+
+	bool FrameCapture::IsActive() const
+	{ return bActive; }
+
+	olc::CaptureStats FrameCapture::GetStats() const
+	{
+		olc::CaptureStats stats;
+		stats.nCaptured = nHead;
+		stats.nWritten = nTail;
+		stats.nDropped = nDropped;
+		return stats;
+	}
+
+	void FrameCapture::Push(const std::vector<LayerDesc>& vLayers)
+	{
+		if (!bActive) return;
+
+		// Single producer, single consumer: only the engine thread moves the head
+		const uint64_t nPos = nHead.load(std::memory_order_relaxed);
+		while (nPos - nTail.load(std::memory_order_acquire) >= vSlots.size())
+		{
+			if (nPolicy == olc::CapturePolicy::DROP)
+			{
+				nDropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			std::this_thread::yield();
+		}
+
+		sSlot& slot = vSlots[nPos % vSlots.size()];
+		const size_t nPixels = size_t(vSize.x) * size_t(vSize.y);
+		slot.nLayers = 0;
+		slot.vTint.clear();
+		for (auto& layer : vLayers)
+		{
+			if (!layer.bShow || layer.funcHook != nullptr || layer.pDrawTarget == nullptr) continue;
+			if (layer.pDrawTarget->width != vSize.x || layer.pDrawTarget->height != vSize.y) continue;
+
+			if (slot.vData.size() < nPixels * (slot.nLayers + 1))
+				slot.vData.resize(nPixels * (slot.nLayers + 1));
+			std::memcpy(slot.vData.data() + nPixels * slot.nLayers, layer.pDrawTarget->GetData(), nPixels * sizeof(olc::Pixel));
+			slot.vTint.push_back(layer.tint);
+			slot.nLayers++;
+		}
+
+		nHead.store(nPos + 1, std::memory_order_release);
+	}
+
+	void FrameCapture::WriterThread()
+	{
+		while (true)
+		{
+			const uint64_t nPos = nTail.load(std::memory_order_relaxed);
+			if (nPos == nHead.load(std::memory_order_acquire))
+			{
+				// Drain whatever is left before honouring a stop request
+				if (!bActive) break;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				continue;
+			}
+
+			Compose(vSlots[nPos % vSlots.size()]);
+			nTail.store(nPos + 1, std::memory_order_release);
+			Write();
+		}
+
+		ofs.flush();
+	}
+
+	void FrameCapture::Compose(const sSlot& slot)
+	{
+		const size_t nPixels = vFrame.size();
+		std::fill(vFrame.begin(), vFrame.end(), olc::BLACK);
+
+		// Layer 0 is at the front, so blend from the back layer forwards
+		for (uint32_t l = slot.nLayers; l-- > 0;)
+		{
+			const olc::Pixel* pSrc = slot.vData.data() + nPixels * l;
+			const olc::Pixel tint = slot.vTint[l];
+			for (size_t i = 0; i < nPixels; i++)
+			{
+				olc::Pixel s = pSrc[i];
+				if (tint != olc::WHITE)
+					s = olc::Pixel(uint8_t(s.r * tint.r / 255), uint8_t(s.g * tint.g / 255), uint8_t(s.b * tint.b / 255), uint8_t(s.a * tint.a / 255));
+
+				if (s.a == 255)
+				{
+					vFrame[i] = s;
+				}
+				else if (s.a > 0)
+				{
+					olc::Pixel& d = vFrame[i];
+					d = olc::Pixel(uint8_t((s.r * s.a + d.r * (255 - s.a)) / 255), uint8_t((s.g * s.a + d.g * (255 - s.a)) / 255),
+						uint8_t((s.b * s.a + d.b * (255 - s.a)) / 255), 255);
+				}
+			}
+		}
+	}
+
+	void FrameCapture::Write()
+	{
+		const size_t nPixels = vFrame.size();
+		if (nFormat == olc::CaptureFormat::Y4M)
+		{
+			// BT.601 studio range, one full resolution plane each for Y, U and V
+			uint8_t* pY = vOut.data();
+			uint8_t* pU = pY + nPixels;
+			uint8_t* pV = pU + nPixels;
+			for (size_t i = 0; i < nPixels; i++)
+			{
+				const int r = vFrame[i].r, g = vFrame[i].g, b = vFrame[i].b;
+				pY[i] = uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+				pU[i] = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+				pV[i] = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+			}
+			ofs << "FRAME\n";
+			ofs.write((const char*)vOut.data(), nPixels * 3);
+		}
+		else
+		{
+			for (size_t i = 0; i < nPixels; i++)
+			{
+				vOut[i * 4 + 0] = vFrame[i].r;
+				vOut[i * 4 + 1] = vFrame[i].g;
+				vOut[i * 4 + 2] = vFrame[i].b;
+				vOut[i * 4 + 3] = vFrame[i].a;
+			}
+			ofs.write((const char*)vOut.data(), nPixels * 4);
+		}
+	}
+
 	// O------------------------------------------------------------------------------O
 	// | olc::PixelGameEngine IMPLEMENTATION                                          |
 	// O------------------------------------------------------------------------------O
@@ -1579,9 +1957,10 @@ namespace olc
 	{}
 
 
-	olc::rcode PixelGameEngine::Construct(int32_t screen_w, int32_t screen_h, int32_t pixel_w, int32_t pixel_h, bool full_screen, bool vsync, bool cohesion)
+	olc::rcode PixelGameEngine::Construct(int32_t screen_w, int32_t screen_h, int32_t pixel_w, int32_t pixel_h, bool full_screen, bool vsync, bool cohesion, bool threaded)
 	{
 		bPixelCohesion = cohesion;
+		bThreadedPresent = threaded;
 		vScreenSize = { screen_w, screen_h };
 		vInvScreenSize = { 1.0f / float(screen_w), 1.0f / float(screen_h) };
 		vPixelSize = { pixel_w, pixel_h };
@@ -1773,9 +2152,24 @@ namespace olc
 	const olc::vi2d& PixelGameEngine::GetScreenPixelSize() const
 	{ return vScreenPixelSize; }
 
+	void PixelGameEngine::SetFrameCallback(std::function<bool(const olc::Sprite*)> f)
+	{ funcFrameCallback = f; }
+
+	olc::rcode PixelGameEngine::StartCapture(const std::string& sFile, olc::CaptureFormat format, olc::CapturePolicy policy, uint32_t nSlots, uint32_t nFPS)
+	{ return frameCapture.Start(sFile, vScreenSize, format, policy, nSlots, nFPS); }
+
+	void PixelGameEngine::StopCapture()
+	{ frameCapture.Stop(); }
+
+	olc::CaptureStats PixelGameEngine::GetCaptureStats() const
+	{ return frameCapture.GetStats(); }
+
 	const olc::vi2d& PixelGameEngine::GetWindowMouse() const
 	{ return vMouseWindowPos; }
 
+	const std::vector<olc::InputEvent>& PixelGameEngine::GetInputEvents() const
+	{ return vInputEvents; }
+
 
 	bool PixelGameEngine::Draw(const olc::vi2d& pos, Pixel p)
 	{
@@ -2737,11 +3131,15 @@ namespace olc
 	}
 
 	void PixelGameEngine::olc_UpdateMouseWheel(int32_t delta)
-	{
-		nMouseWheelDeltaCache += delta;
-	}
+	{ olc_UpdateMouseWheel(delta, std::chrono::system_clock::now()); }
+
+	void PixelGameEngine::olc_UpdateMouseWheel(int32_t delta, const std::chrono::time_point<std::chrono::system_clock>& tp)
+	{ inputQueue.Push({ olc::InputEvent::MOUSE_WHEEL, delta, vMousePosCache, tp }); }
 
 	void PixelGameEngine::olc_UpdateMouse(int32_t x, int32_t y)
+	{ olc_UpdateMouse(x, y, std::chrono::system_clock::now()); }
+
+	void PixelGameEngine::olc_UpdateMouse(int32_t x, int32_t y, const std::chrono::time_point<std::chrono::system_clock>& tp)
 	{
 		// Mouse coords come in screen space
 		// But leave in pixel space
@@ -2756,13 +3154,26 @@ namespace olc
 		if (vMousePosCache.y >= (int32_t)vScreenSize.y)	vMousePosCache.y = vScreenSize.y - 1;
 		if (vMousePosCache.x < 0) vMousePosCache.x = 0;
 		if (vMousePosCache.y < 0) vMousePosCache.y = 0;
+
+		// Motion is plentiful, so never let it crowd out buttons and keys
+		if (inputQueue.Size() < olc::InputQueue::nCapacity / 2)
+			inputQueue.Push({ olc::InputEvent::MOUSE_MOVE, 0, vMousePosCache, tp });
 	}
 
 	void PixelGameEngine::olc_UpdateMouseState(int32_t button, bool state)
-	{ pMouseNewState[button] = state; }
+	{ olc_UpdateMouseState(button, state, std::chrono::system_clock::now()); }
+
+	void PixelGameEngine::olc_UpdateMouseState(int32_t button, bool state, const std::chrono::time_point<std::chrono::system_clock>& tp)
+	{ inputQueue.Push({ state ? olc::InputEvent::MOUSE_DOWN : olc::InputEvent::MOUSE_UP, button, vMousePosCache, tp }); }
 
 	void PixelGameEngine::olc_UpdateKeyState(int32_t key, bool state)
-	{ pKeyNewState[key] = state; }
+	{ olc_UpdateKeyState(key, state, std::chrono::system_clock::now()); }
+
+	void PixelGameEngine::olc_UpdateKeyState(int32_t key, bool state, const std::chrono::time_point<std::chrono::system_clock>& tp)
+	{
+		if (key == olc::Key::NONE) return;
+		inputQueue.Push({ state ? olc::InputEvent::KEY_DOWN : olc::InputEvent::KEY_UP, key, vMousePosCache, tp });
+	}
 
 	void PixelGameEngine::olc_UpdateMouseFocus(bool state)
 	{ bHasMouseFocus = state; }
@@ -2773,6 +3184,12 @@ namespace olc
 	void PixelGameEngine::olc_Terminate()
 	{ bAtomActive = false; }
 
+	void PixelGameEngine::olc_FrameComposited(const olc::Sprite* frame)
+	{
+		if (funcFrameCallback && !funcFrameCallback(frame))
+			bAtomActive = false;
+	}
+
 	void PixelGameEngine::EngineThread()
 	{
 		// Allow platform to do stuff here if needed, since its now in the
@@ -2787,8 +3204,28 @@ namespace olc
 
 		while (bAtomActive)
 		{
-			// Run as fast as possible
-			while (bAtomActive) { olc_CoreUpdate(); }
+			if (bThreadedPresent)
+			{
+				// User updates run on their own thread, while this one keeps the
+				// graphics context and presents whatever frame is newest. Platforms
+				// such as X11 want their events handled, and their window touched, on
+				// the thread that made the context, so that stays here as well and
+				// input reaches the simulation through the input queue
+				std::thread tSimulation([&]() { while (bAtomActive) { olc_CoreSimulate(); } });
+				while (bAtomActive)
+				{
+					platform->HandleSystemEvent();
+					uint32_t fps = nTitleFPS.exchange(0, std::memory_order_relaxed);
+					if (fps != 0) olc_UpdateTitle(fps);
+					if (!olc_PresentLayers()) std::this_thread::yield();
+				}
+				tSimulation.join();
+			}
+			else
+			{
+				// Run as fast as possible
+				while (bAtomActive) { olc_CoreUpdate(); }
+			}
 
 			// Allow the user to free resources if they have overrided the destroy function
 			if (!OnUserDestroy())
@@ -2798,6 +3235,9 @@ namespace olc
 			}
 		}
 
+		// Flush any frames still waiting to be written
+		frameCapture.Stop();
+
 		platform->ThreadCleanUp();
 	}
 
@@ -2815,12 +3255,25 @@ namespace olc
 		vLayers[0].bShow = true;
 		SetDrawTarget(nullptr);
 
+		vKeysTouched.reserve(256);
+		vKeysChanged.reserve(256);
+		vInputEvents.reserve(olc::InputQueue::nCapacity);
+
 		m_tp1 = std::chrono::system_clock::now();
 		m_tp2 = std::chrono::system_clock::now();
 	}
 
 
 	void PixelGameEngine::olc_CoreUpdate()
+	{
+		// Some platforms will need to check for events
+		platform->HandleSystemEvent();
+
+		olc_CoreSimulate();
+		olc_RenderLayers(vLayers, vViewPos, vViewSize);
+	}
+
+	void PixelGameEngine::olc_CoreSimulate()
 	{
 		// Handle Timing
 		m_tp2 = std::chrono::system_clock::now();
@@ -2831,9 +3284,6 @@ namespace olc
 		float fElapsedTime = elapsedTime.count();
 		fLastElapsed = fElapsedTime;
 
-		// Some platforms will need to check for events
-		platform->HandleSystemEvent();
-
 		// Compare hardware input states from previous frame
 		auto ScanHardware = [&](HWButton* pKeys, bool* pStateOld, bool* pStateNew, uint32_t nKeyCount)
 		{
@@ -2858,13 +3308,56 @@ namespace olc
 			}
 		};
 
-		ScanHardware(pKeyboardState, pKeyOldState, pKeyNewState, 256);
-		ScanHardware(pMouseState, pMouseOldState, pMouseNewState, nMouseButtons);
+		// Only keys that had an edge last frame need their edges cleared
+		for (auto k : vKeysChanged)
+		{
+			pKeyboardState[k].bPressed = false;
+			pKeyboardState[k].bReleased = false;
+		}
+		vKeysChanged.clear();
+
+		// Drain the platform's events in order, remembering which keys they touched.
+		// The mouse is where the latest event found it, so nothing the platform's
+		// thread writes is read here outside the queue
+		vInputEvents.clear();
+		nMouseWheelDelta = 0;
+		olc::InputEvent event;
+		while (inputQueue.Pop(event))
+		{
+			vInputEvents.push_back(event);
+			vMousePos = event.vPos;
+			switch (event.type)
+			{
+			case olc::InputEvent::KEY_DOWN:
+			case olc::InputEvent::KEY_UP:
+			{
+				uint8_t k = uint8_t(event.nCode);
+				pKeyNewState[k] = event.type == olc::InputEvent::KEY_DOWN;
+				if (!pKeyTouched[k]) { pKeyTouched[k] = true; vKeysTouched.push_back(k); }
+				break;
+			}
+			case olc::InputEvent::MOUSE_DOWN:
+			case olc::InputEvent::MOUSE_UP:
+				if (event.nCode >= 0 && event.nCode < nMouseButtons)
+					pMouseNewState[event.nCode] = event.type == olc::InputEvent::MOUSE_DOWN;
+				break;
+			case olc::InputEvent::MOUSE_WHEEL:
+				nMouseWheelDelta += event.nCode;
+				break;
+			default:
+				break;
+			}
+		}
+
+		for (auto k : vKeysTouched)
+		{
+			pKeyTouched[k] = false;
+			if (pKeyNewState[k] != pKeyOldState[k]) vKeysChanged.push_back(k);
+			ScanHardware(&pKeyboardState[k], &pKeyOldState[k], &pKeyNewState[k], 1);
+		}
+		vKeysTouched.clear();
 
-		// Cache mouse coordinates so they remain consistent during frame
-		vMousePos = vMousePosCache;
-		nMouseWheelDelta = nMouseWheelDeltaCache;
-		nMouseWheelDeltaCache = 0;
+		ScanHardware(pMouseState, pMouseOldState, pMouseNewState, nMouseButtons);
 
 		//	renderer->ClearBuffer(olc::BLACK, true);
 
@@ -2872,16 +3365,47 @@ namespace olc
 		if (!OnUserUpdate(fElapsedTime))
 			bAtomActive = false;
 
-		// Display Frame
-		renderer->UpdateViewport(vViewPos, vViewSize);
-		renderer->ClearBuffer(olc::BLACK, true);
+		// Hand the finished layers to the capture writer, if recording
+		frameCapture.Push(vLayers);
 
 		// Layer 0 must always exist
 		vLayers[0].bUpdate = true;
 		vLayers[0].bShow = true;
+
+		// Hand the finished layers to the presentation thread
+		if (bThreadedPresent)
+			olc_PublishLayers();
+
+		// Update Title Bar
+		fFrameTimer += fElapsedTime;
+		nFrameCount++;
+		if (fFrameTimer >= 1.0f)
+		{
+			nLastFPS = nFrameCount;
+			fFrameTimer -= 1.0f;
+			if (bThreadedPresent)
+				nTitleFPS.store(uint32_t(nFrameCount), std::memory_order_relaxed);
+			else
+				olc_UpdateTitle(uint32_t(nFrameCount));
+			nFrameCount = 0;
+		}
+	}
+
+	void PixelGameEngine::olc_UpdateTitle(uint32_t fps)
+	{
+		std::string sTitle = "OneLoneCoder.com - Pixel Game Engine - " + sAppName + " - FPS: " + std::to_string(fps);
+		platform->SetWindowTitle(sTitle);
+	}
+
+	void PixelGameEngine::olc_RenderLayers(std::vector<LayerDesc>& layers, const olc::vi2d& viewPos, const olc::vi2d& viewSize)
+	{
+		// Display Frame
+		renderer->UpdateViewport(viewPos, viewSize);
+		renderer->ClearBuffer(olc::BLACK, true);
+
 		renderer->PrepareDrawing();
 
-		for (auto layer = vLayers.rbegin(); layer != vLayers.rend(); ++layer)
+		for (auto layer = layers.rbegin(); layer != layers.rend(); ++layer)
 		{
 			if (layer->bShow)
 			{
@@ -2911,18 +3435,58 @@ namespace olc
 
 		// Present Graphics to screen
 		renderer->DisplayFrame();
+	}
 
-		// Update Title Bar
-		fFrameTimer += fElapsedTime;
-		nFrameCount++;
-		if (fFrameTimer >= 1.0f)
+	void PixelGameEngine::olc_PublishLayers()
+	{
+		LayerFrame& frame = vLayerFrames[nBackFrame];
+		frame.vLayers.resize(vLayers.size());
+		frame.vSprites.resize(vLayers.size());
+
+		for (size_t i = 0; i < vLayers.size(); i++)
 		{
-			nLastFPS = nFrameCount;
-			fFrameTimer -= 1.0f;
-			std::string sTitle = "OneLoneCoder.com - Pixel Game Engine - " + sAppName + " - FPS: " + std::to_string(nFrameCount);
-			platform->SetWindowTitle(sTitle);
-			nFrameCount = 0;
+			LayerDesc& src = vLayers[i];
+			LayerDesc& dst = frame.vLayers[i];
+			dst.vOffset = src.vOffset;
+			dst.vScale = src.vScale;
+			dst.bShow = src.bShow;
+			dst.nResID = src.nResID;
+			dst.tint = src.tint;
+			dst.funcHook = src.funcHook;
+
+			// A frame may be skipped by the presenter, so every shown layer travels
+			// with its pixels rather than relying on an earlier upload
+			dst.bUpdate = src.bShow && src.funcHook == nullptr;
+			if (dst.bUpdate)
+			{
+				auto& spr = frame.vSprites[i];
+				if (!spr || spr->width != src.pDrawTarget->width || spr->height != src.pDrawTarget->height)
+					spr = std::make_unique<olc::Sprite>(src.pDrawTarget->width, src.pDrawTarget->height);
+				std::memcpy(spr->GetData(), src.pDrawTarget->GetData(), size_t(spr->width) * size_t(spr->height) * sizeof(olc::Pixel));
+				dst.pDrawTarget = spr.get();
+			}
+
+			// Swapping keeps the capacity of both vectors, so steady state is allocation free
+			dst.vecDecalInstance.swap(src.vecDecalInstance);
+			src.vecDecalInstance.clear();
+			src.bUpdate = false;
 		}
+
+		// Lock free triple buffer: swap the back frame with the shared one and mark it fresh
+		nBackFrame = nSharedFrame.exchange(uint8_t(nBackFrame | 4), std::memory_order_acq_rel) & 3;
+	}
+
+	bool PixelGameEngine::olc_PresentLayers()
+	{
+		if ((nSharedFrame.load(std::memory_order_acquire) & 4) == 0)
+			return false;
+
+		nFrontFrame = nSharedFrame.exchange(nFrontFrame, std::memory_order_acq_rel) & 3;
+		LayerFrame& frame = vLayerFrames[nFrontFrame];
+
+		// The viewport follows the window, whose events are handled on this thread
+		olc_RenderLayers(frame.vLayers, vViewPos, vViewSize);
+		return true;
 	}
 
 	void PixelGameEngine::olc_ConstructFontSheet()
@@ -3324,6 +3888,300 @@ namespace olc
 
 
 
+// O------------------------------------------------------------------------------O
+// | START RENDERER: Headless (software compositing into memory, no GPU)          |
+// O------------------------------------------------------------------------------O
+#if defined(OLC_GFX_HEADLESS)
+namespace olc
+{
+	class Renderer_Headless : public olc::Renderer
+	{
+	private:
+		struct sTexture
+		{
+			int32_t width = 0;
+			int32_t height = 0;
+			bool bFiltered = false;
+			bool bInUse = false;
+			std::vector<olc::Pixel> vData;
+		};
+
+		// Texture ID 0 means "no texture", as it does in OpenGL
+		std::vector<sTexture> vTextures = std::vector<sTexture>(1);
+		uint32_t nBoundTexture = 0;
+		olc::DecalMode nDecalMode = olc::DecalMode::NORMAL;
+		std::unique_ptr<olc::Sprite> pFrame;
+		std::vector<int32_t> vColumnTexel;
+
+	public:
+		void PrepareDevice() override
+		{}
+
+		olc::rcode CreateDevice(std::vector<void*> params, bool bFullScreen, bool bVSYNC) override
+		{
+			UNUSED(params);
+			UNUSED(bFullScreen);
+			UNUSED(bVSYNC);
+			pFrame = std::make_unique<olc::Sprite>(1, 1);
+			return olc::rcode::OK;
+		}
+
+		olc::rcode DestroyDevice() override
+		{
+			pFrame.reset();
+			vTextures.resize(1);
+			return olc::rcode::OK;
+		}
+
+		void DisplayFrame() override
+		{
+			ptrPGE->olc_FrameComposited(pFrame.get());
+		}
+
+		void PrepareDrawing() override
+		{
+			SetDecalMode(olc::DecalMode::NORMAL);
+		}
+
+		void SetDecalMode(const olc::DecalMode& mode) override
+		{
+			nDecalMode = mode;
+		}
+
+		void DrawLayerQuad(const olc::vf2d& offset, const olc::vf2d& scale, const olc::Pixel tint) override
+		{
+			const sTexture& tex = vTextures[nBoundTexture];
+			if (tex.vData.empty()) return;
+
+			const int32_t fw = pFrame->width;
+			const int32_t fh = pFrame->height;
+			olc::Pixel* pDst = pFrame->GetData();
+
+			// Nearest texel per framebuffer column, computed once per quad
+			vColumnTexel.resize(fw);
+			for (int32_t x = 0; x < fw; x++)
+				vColumnTexel[x] = TexelIndex((float(x) + 0.5f) / float(fw) * scale.x + offset.x, tex.width);
+
+			const bool bOpaqueCopy = tint == olc::WHITE && nDecalMode == olc::DecalMode::NORMAL && !tex.bFiltered;
+
+			for (int32_t y = 0; y < fh; y++)
+			{
+				float v = (float(y) + 0.5f) / float(fh) * scale.y + offset.y;
+				olc::Pixel* pRow = pDst + y * fw;
+
+				if (tex.bFiltered)
+				{
+					for (int32_t x = 0; x < fw; x++)
+					{
+						float u = (float(x) + 0.5f) / float(fw) * scale.x + offset.x;
+						pRow[x] = Blend(Modulate(Sample(tex, u, v), tint), pRow[x]);
+					}
+					continue;
+				}
+
+				const olc::Pixel* pSrc = tex.vData.data() + TexelIndex(v, tex.height) * tex.width;
+				for (int32_t x = 0; x < fw; x++)
+				{
+					olc::Pixel p = pSrc[vColumnTexel[x]];
+					if (bOpaqueCopy && p.a == 255)
+						pRow[x] = p;
+					else
+						pRow[x] = Blend(Modulate(p, tint), pRow[x]);
+				}
+			}
+		}
+
+		void DrawDecalQuad(const olc::DecalInstance& decal) override
+		{
+			SetDecalMode(decal.mode);
+			const sTexture* tex = nullptr;
+			if (decal.decal != nullptr && decal.decal->id > 0 && uint32_t(decal.decal->id) < vTextures.size())
+				tex = &vTextures[decal.decal->id];
+
+			// The OpenGL renderer only tints textured decals with the first colour
+			olc::Pixel tint[4];
+			for (int i = 0; i < 4; i++)
+				tint[i] = tex != nullptr ? decal.tint[0] : decal.tint[i];
+
+			DrawTriangle(decal, tex, tint, 0, 1, 2);
+			DrawTriangle(decal, tex, tint, 0, 2, 3);
+		}
+
+		uint32_t CreateTexture(const uint32_t width, const uint32_t height, const bool filtered) override
+		{
+			uint32_t id = 1;
+			while (id < vTextures.size() && vTextures[id].bInUse) id++;
+			if (id == vTextures.size()) vTextures.emplace_back();
+
+			sTexture& tex = vTextures[id];
+			tex.width = int32_t(width);
+			tex.height = int32_t(height);
+			tex.bFiltered = filtered;
+			tex.bInUse = true;
+			tex.vData.clear();
+			nBoundTexture = id;
+			return id;
+		}
+
+		uint32_t DeleteTexture(const uint32_t id) override
+		{
+			if (id > 0 && id < vTextures.size())
+			{
+				vTextures[id].bInUse = false;
+				vTextures[id].vData.clear();
+				vTextures[id].vData.shrink_to_fit();
+			}
+			return id;
+		}
+
+		void UpdateTexture(uint32_t id, olc::Sprite* spr) override
+		{
+			if (id == 0 || id >= vTextures.size() || spr == nullptr) return;
+			sTexture& tex = vTextures[id];
+			tex.width = spr->width;
+			tex.height = spr->height;
+			tex.vData.resize(size_t(spr->width) * size_t(spr->height));
+			std::memcpy(tex.vData.data(), spr->GetData(), tex.vData.size() * sizeof(olc::Pixel));
+		}
+
+		void ApplyTexture(uint32_t id) override
+		{
+			nBoundTexture = id < vTextures.size() ? id : 0;
+		}
+
+		void ClearBuffer(olc::Pixel p, bool bDepth) override
+		{
+			UNUSED(bDepth);
+			std::fill(pFrame->GetData(), pFrame->GetData() + pFrame->width * pFrame->height, p);
+		}
+
+		void UpdateViewport(const olc::vi2d& pos, const olc::vi2d& size) override
+		{
+			UNUSED(pos);
+			if (size.x <= 0 || size.y <= 0) return;
+			if (pFrame == nullptr || pFrame->width != size.x || pFrame->height != size.y)
+				pFrame = std::make_unique<olc::Sprite>(size.x, size.y);
+		}
+
+	private:
+		static int32_t TexelIndex(float u, int32_t size)
+		{
+			// Clamped, as with GL_CLAMP
+			return std::max(0, std::min(size - 1, int32_t(std::floor(u * float(size)))));
+		}
+
+		static olc::Pixel Sample(const sTexture& tex, float u, float v)
+		{
+			if (!tex.bFiltered)
+				return tex.vData[TexelIndex(v, tex.height) * tex.width + TexelIndex(u, tex.width)];
+
+			u = u * tex.width - 0.5f;
+			v = v * tex.height - 0.5f;
+			int32_t x = int32_t(std::floor(u));
+			int32_t y = int32_t(std::floor(v));
+			float fu = u - x;
+			float fv = v - y;
+
+			auto texel = [&](int32_t tx, int32_t ty)
+			{
+				tx = std::max(0, std::min(tex.width - 1, tx));
+				ty = std::max(0, std::min(tex.height - 1, ty));
+				return tex.vData[ty * tex.width + tx];
+			};
+
+			olc::Pixel p1 = texel(x, y), p2 = texel(x + 1, y), p3 = texel(x, y + 1), p4 = texel(x + 1, y + 1);
+			auto lerp = [&](uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+			{
+				return uint8_t((a * (1.0f - fu) + b * fu) * (1.0f - fv) + (c * (1.0f - fu) + d * fu) * fv);
+			};
+
+			return olc::Pixel(lerp(p1.r, p2.r, p3.r, p4.r), lerp(p1.g, p2.g, p3.g, p4.g),
+				lerp(p1.b, p2.b, p3.b, p4.b), lerp(p1.a, p2.a, p3.a, p4.a));
+		}
+
+		static olc::Pixel Modulate(const olc::Pixel& p, const olc::Pixel& tint)
+		{
+			return olc::Pixel(uint8_t(p.r * tint.r / 255), uint8_t(p.g * tint.g / 255),
+				uint8_t(p.b * tint.b / 255), uint8_t(p.a * tint.a / 255));
+		}
+
+		// Mirrors the glBlendFunc() choices of the OpenGL renderer
+		olc::Pixel Blend(const olc::Pixel& s, const olc::Pixel& d) const
+		{
+			const int a = s.a;
+			auto mix = [&](int sc, int dc)
+			{
+				int c = 0;
+				switch (nDecalMode)
+				{
+				case olc::DecalMode::NORMAL:         c = (sc * a + dc * (255 - a)) / 255; break;
+				case olc::DecalMode::ADDITIVE:       c = (sc * a) / 255 + dc; break;
+				case olc::DecalMode::MULTIPLICATIVE: c = (sc * dc + dc * (255 - a)) / 255; break;
+				case olc::DecalMode::STENCIL:        c = (dc * a) / 255; break;
+				case olc::DecalMode::ILLUMINATE:     c = (sc * (255 - a) + dc * a) / 255; break;
+				}
+				return uint8_t(std::min(c, 255));
+			};
+
+			return olc::Pixel(mix(s.r, d.r), mix(s.g, d.g), mix(s.b, d.b), 255);
+		}
+
+		void DrawTriangle(const olc::DecalInstance& decal, const sTexture* tex, const olc::Pixel* tint, int i0, int i1, int i2)
+		{
+			const float fw = float(pFrame->width);
+			const float fh = float(pFrame->height);
+			const int idx[3] = { i0, i1, i2 };
+
+			// Normalised device coordinates to framebuffer pixels
+			olc::vf2d p[3];
+			for (int i = 0; i < 3; i++)
+				p[i] = { (decal.pos[idx[i]].x + 1.0f) * 0.5f * fw, (1.0f - decal.pos[idx[i]].y) * 0.5f * fh };
+
+			float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+			if (area == 0.0f) return;
+
+			int32_t x0 = std::max(0, int32_t(std::floor(std::min({ p[0].x, p[1].x, p[2].x }))));
+			int32_t x1 = std::min(pFrame->width - 1, int32_t(std::ceil(std::max({ p[0].x, p[1].x, p[2].x }))));
+			int32_t y0 = std::max(0, int32_t(std::floor(std::min({ p[0].y, p[1].y, p[2].y }))));
+			int32_t y1 = std::min(pFrame->height - 1, int32_t(std::ceil(std::max({ p[0].y, p[1].y, p[2].y }))));
+
+			olc::Pixel* pDst = pFrame->GetData();
+			for (int32_t y = y0; y <= y1; y++)
+			{
+				for (int32_t x = x0; x <= x1; x++)
+				{
+					olc::vf2d c = { float(x) + 0.5f, float(y) + 0.5f };
+					float b0 = ((p[1].x - c.x) * (p[2].y - c.y) - (p[2].x - c.x) * (p[1].y - c.y)) / area;
+					float b1 = ((p[2].x - c.x) * (p[0].y - c.y) - (p[0].x - c.x) * (p[2].y - c.y)) / area;
+					float b2 = 1.0f - b0 - b1;
+					if (b0 < 0.0f || b1 < 0.0f || b2 < 0.0f) continue;
+
+					auto lerp = [&](float a, float b, float c) { return a * b0 + b * b1 + c * b2; };
+					olc::Pixel col(
+						uint8_t(lerp(tint[i0].r, tint[i1].r, tint[i2].r)), uint8_t(lerp(tint[i0].g, tint[i1].g, tint[i2].g)),
+						uint8_t(lerp(tint[i0].b, tint[i1].b, tint[i2].b)), uint8_t(lerp(tint[i0].a, tint[i1].a, tint[i2].a)));
+					if (tex != nullptr && !tex->vData.empty())
+					{
+						// Texture coordinates are projective (see DrawWarpedDecal)
+						float q = lerp(decal.w[i0], decal.w[i1], decal.w[i2]);
+						float u = lerp(decal.uv[i0].x, decal.uv[i1].x, decal.uv[i2].x) / q;
+						float v = lerp(decal.uv[i0].y, decal.uv[i1].y, decal.uv[i2].y) / q;
+						col = Modulate(Sample(*tex, u, v), col);
+					}
+
+					pDst[y * pFrame->width + x] = Blend(col, pDst[y * pFrame->width + x]);
+				}
+			}
+		}
+	};
+}
+#endif
+// O------------------------------------------------------------------------------O
+// | END RENDERER: Headless                                                       |
+// O------------------------------------------------------------------------------O
+
+
+
 
 // O------------------------------------------------------------------------------O
 // | START IMAGE LOADER: GDI+, Windows Only, always exists, a little slow         |
@@ -3808,10 +4666,10 @@ namespace olc
 			case WM_MOUSELEAVE: ptrPGE->olc_UpdateMouseFocus(false);                                    return 0;
 			case WM_SETFOCUS:	ptrPGE->olc_UpdateKeyFocus(true);                                       return 0;
 			case WM_KILLFOCUS:	ptrPGE->olc_UpdateKeyFocus(false);                                      return 0;
-			case WM_KEYDOWN:	ptrPGE->olc_UpdateKeyState(mapKeys[wParam], true);                      return 0;
-			case WM_KEYUP:		ptrPGE->olc_UpdateKeyState(mapKeys[wParam], false);                     return 0;
-			case WM_SYSKEYDOWN: ptrPGE->olc_UpdateKeyState(mapKeys[wParam], true);						return 0;
-			case WM_SYSKEYUP:	ptrPGE->olc_UpdateKeyState(mapKeys[wParam], false);						return 0;
+			case WM_KEYDOWN:	ptrPGE->olc_UpdateKeyState(mapKeys.Find(wParam), true);                      return 0;
+			case WM_KEYUP:		ptrPGE->olc_UpdateKeyState(mapKeys.Find(wParam), false);                     return 0;
+			case WM_SYSKEYDOWN: ptrPGE->olc_UpdateKeyState(mapKeys.Find(wParam), true);						return 0;
+			case WM_SYSKEYUP:	ptrPGE->olc_UpdateKeyState(mapKeys.Find(wParam), false);						return 0;
 			case WM_LBUTTONDOWN:ptrPGE->olc_UpdateMouseState(0, true);                                  return 0;
 			case WM_LBUTTONUP:	ptrPGE->olc_UpdateMouseState(0, false);                                 return 0;
 			case WM_RBUTTONDOWN:ptrPGE->olc_UpdateMouseState(1, true);                                  return 0;
@@ -3849,6 +4707,23 @@ namespace olc
 		X11::XVisualInfo* olc_VisualInfo;
 		X11::Colormap                olc_ColourMap;
 		X11::XSetWindowAttributes    olc_SetWindowAttribs;
+		int64_t                      nServerTimeOffset = 0;
+		bool                         bServerTimeOffset = false;
+
+		// X server timestamps are milliseconds on the server's own clock. The smallest
+		// offset seen to our clock maps them back without the queueing delay, so events
+		// keep their real spacing even when several are handled in one frame
+		std::chrono::time_point<std::chrono::system_clock> ServerTime(X11::Time t)
+		{
+			int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+			int64_t offset = now - int64_t(t);
+			if (!bServerTimeOffset || offset < nServerTimeOffset || offset - nServerTimeOffset > 60000)
+			{
+				nServerTimeOffset = offset;
+				bServerTimeOffset = true;
+			}
+			return std::chrono::time_point<std::chrono::system_clock>(std::chrono::milliseconds(int64_t(t) + nServerTimeOffset));
+		}
 
 	public:
 		virtual olc::rcode ApplicationStartUp() override
@@ -4010,47 +4885,45 @@ namespace olc
 					XConfigureEvent xce = xev.xconfigure;
 					ptrPGE->olc_UpdateWindowSize(xce.width, xce.height);
 				}
-				else if (xev.type == KeyPress)
+				else if (xev.type == KeyPress || xev.type == KeyRelease)
 				{
+					bool bDown = xev.type == KeyPress;
+					auto tp = ServerTime(xev.xkey.time);
 					KeySym sym = XLookupKeysym(&xev.xkey, 0);
-					ptrPGE->olc_UpdateKeyState(mapKeys[sym], true);
+					uint8_t key = mapKeys.Find(sym);
 					XKeyEvent* e = (XKeyEvent*)&xev; // Because DragonEye loves numpads
 					XLookupString(e, NULL, 0, &sym, NULL);
-					ptrPGE->olc_UpdateKeyState(mapKeys[sym], true);
-				}
-				else if (xev.type == KeyRelease)
-				{
-					KeySym sym = XLookupKeysym(&xev.xkey, 0);
-					ptrPGE->olc_UpdateKeyState(mapKeys[sym], false);
-					XKeyEvent* e = (XKeyEvent*)&xev;
-					XLookupString(e, NULL, 0, &sym, NULL);
-					ptrPGE->olc_UpdateKeyState(mapKeys[sym], false);
+					uint8_t alt = mapKeys.Find(sym);
+					ptrPGE->olc_UpdateKeyState(key, bDown, tp);
+					if (alt != key) ptrPGE->olc_UpdateKeyState(alt, bDown, tp);
 				}
 				else if (xev.type == ButtonPress)
 				{
+					auto tp = ServerTime(xev.xbutton.time);
 					switch (xev.xbutton.button)
 					{
-					case 1:	ptrPGE->olc_UpdateMouseState(0, true); break;
-					case 2:	ptrPGE->olc_UpdateMouseState(2, true); break;
-					case 3:	ptrPGE->olc_UpdateMouseState(1, true); break;
-					case 4:	ptrPGE->olc_UpdateMouseWheel(120); break;
-					case 5:	ptrPGE->olc_UpdateMouseWheel(-120); break;
+					case 1:	ptrPGE->olc_UpdateMouseState(0, true, tp); break;
+					case 2:	ptrPGE->olc_UpdateMouseState(2, true, tp); break;
+					case 3:	ptrPGE->olc_UpdateMouseState(1, true, tp); break;
+					case 4:	ptrPGE->olc_UpdateMouseWheel(120, tp); break;
+					case 5:	ptrPGE->olc_UpdateMouseWheel(-120, tp); break;
 					default: break;
 					}
 				}
 				else if (xev.type == ButtonRelease)
 				{
+					auto tp = ServerTime(xev.xbutton.time);
 					switch (xev.xbutton.button)
 					{
-					case 1:	ptrPGE->olc_UpdateMouseState(0, false); break;
-					case 2:	ptrPGE->olc_UpdateMouseState(2, false); break;
-					case 3:	ptrPGE->olc_UpdateMouseState(1, false); break;
+					case 1:	ptrPGE->olc_UpdateMouseState(0, false, tp); break;
+					case 2:	ptrPGE->olc_UpdateMouseState(2, false, tp); break;
+					case 3:	ptrPGE->olc_UpdateMouseState(1, false, tp); break;
 					default: break;
 					}
 				}
 				else if (xev.type == MotionNotify)
 				{
-					ptrPGE->olc_UpdateMouse(xev.xmotion.x, xev.xmotion.y);
+					ptrPGE->olc_UpdateMouse(xev.xmotion.x, xev.xmotion.y, ServerTime(xev.xmotion.time));
 				}
 				else if (xev.type == FocusIn)
 				{
@@ -4077,6 +4950,71 @@ namespace olc
 
 
 
+// O------------------------------------------------------------------------------O
+// | START PLATFORM: HEADLESS (no window, no display, no input)                   |
+// O------------------------------------------------------------------------------O
+#if defined(OLC_PLATFORM_HEADLESS)
+namespace olc
+{
+	class Platform_Headless : public olc::Platform
+	{
+	public:
+		virtual olc::rcode ApplicationStartUp() override
+		{ return olc::rcode::OK; }
+
+		virtual olc::rcode ApplicationCleanUp() override
+		{ return olc::rcode::OK; }
+
+		virtual olc::rcode ThreadStartUp() override
+		{ return olc::rcode::OK; }
+
+		virtual olc::rcode ThreadCleanUp() override
+		{
+			renderer->DestroyDevice();
+			return olc::OK;
+		}
+
+		virtual olc::rcode CreateGraphics(bool bFullScreen, bool bEnableVSYNC, const olc::vi2d& vViewPos, const olc::vi2d& vViewSize) override
+		{
+			if (renderer->CreateDevice({}, bFullScreen, bEnableVSYNC) == olc::rcode::OK)
+			{
+				renderer->UpdateViewport(vViewPos, vViewSize);
+				return olc::rcode::OK;
+			}
+			else
+				return olc::rcode::FAIL;
+		}
+
+		virtual olc::rcode CreateWindowPane(const olc::vi2d& vWindowPos, olc::vi2d& vWindowSize, bool bFullScreen) override
+		{
+			// There is no window, the "window" is the requested size in memory
+			UNUSED(vWindowPos);
+			UNUSED(vWindowSize);
+			UNUSED(bFullScreen);
+			return olc::rcode::OK;
+		}
+
+		virtual olc::rcode SetWindowTitle(const std::string& s) override
+		{
+			UNUSED(s);
+			return olc::rcode::OK;
+		}
+
+		virtual olc::rcode StartSystemEventLoop() override
+		{ return olc::rcode::OK; }
+
+		virtual olc::rcode HandleSystemEvent() override
+		{ return olc::rcode::OK; }
+	};
+}
+#endif
+// O------------------------------------------------------------------------------O
+// | END PLATFORM: HEADLESS                                                       |
+// O------------------------------------------------------------------------------O
+
+
+
+
 // O------------------------------------------------------------------------------O
 // | START PLATFORM: GLUT (used to make it simple for Apple)                      |
 // O------------------------------------------------------------------------------O
@@ -4208,8 +5146,8 @@ namespace olc {
 					break;
 				}
 
-				if (mapKeys[key])
-					ptrPGE->olc_UpdateKeyState(mapKeys[key], true);
+				if (mapKeys.Find(key))
+					ptrPGE->olc_UpdateKeyState(mapKeys.Find(key), true);
 				});
 
 			glutKeyboardUpFunc([](unsigned char key, int x, int y) -> void {
@@ -4230,19 +5168,19 @@ namespace olc {
 					break;
 				}
 
-				if (mapKeys[key])
-					ptrPGE->olc_UpdateKeyState(mapKeys[key], false);
+				if (mapKeys.Find(key))
+					ptrPGE->olc_UpdateKeyState(mapKeys.Find(key), false);
 				});
 
 			//Special keys
 			glutSpecialFunc([](int key, int x, int y) -> void {
-				if (mapKeys[key])
-					ptrPGE->olc_UpdateKeyState(mapKeys[key], true);
+				if (mapKeys.Find(key))
+					ptrPGE->olc_UpdateKeyState(mapKeys.Find(key), true);
 				});
 
 			glutSpecialUpFunc([](int key, int x, int y) -> void {
-				if (mapKeys[key])
-					ptrPGE->olc_UpdateKeyState(mapKeys[key], false);
+				if (mapKeys.Find(key))
+					ptrPGE->olc_UpdateKeyState(mapKeys.Find(key), false);
 				});
 
 			glutMouseFunc([](int button, int state, int x, int y) -> void {
@@ -4317,6 +5255,9 @@ namespace olc {
 
 		Platform_GLUT::bActiveRef = &bAtomActive;
 
+		// GLUT calls olc_CoreUpdate from its own loop, so there is no thread to present on
+		bThreadedPresent = false;
+
 		glutWMCloseFunc(Platform_GLUT::ExitMainLoop);
 
 		bAtomActive = true;
@@ -4369,6 +5310,10 @@ namespace olc
 		platform = std::make_unique<olc::Platform_GLUT>();
 #endif
 
+#if defined(OLC_PLATFORM_HEADLESS)
+		platform = std::make_unique<olc::Platform_Headless>();
+#endif
+
 
 
 #if defined(OLC_GFX_OPENGL10)
@@ -4391,6 +5336,10 @@ namespace olc
 		renderer = std::make_unique<olc::Renderer_DX11>();
 #endif
 
+#if defined(OLC_GFX_HEADLESS)
+		renderer = std::make_unique<olc::Renderer_Headless>();
+#endif
+
 		// Associate components with PGE instance
 		platform->ptrPGE = this;
 		renderer->ptrPGE = this;
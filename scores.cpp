@@ -0,0 +1,43 @@
+#include "ScoreStore.hpp"
+
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+
+// Lists the best runs in a score log, after recovering it if a crash cut it short.
+//
+//   SnakeScores <log> [count]
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <log> [count]" << std::endl;
+        return 2;
+    }
+
+    try
+    {
+        ScoreStore scores(argv[1]);
+        auto count = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10;
+        static const char* deaths[] = {"wall", "body", "bad", "quit"};
+
+        std::cout << scores.Runs() << " runs" << std::endl;
+
+        for (auto& run : scores.Top(count))
+        {
+            auto time = std::time_t(run.time / 1000);
+            std::cout << std::setw(6) << run.score << std::setw(6) << run.length << std::setw(8) << run.ticks << "  "
+                      << std::setw(4) << deaths[size_t(run.death) & 3] << "  "
+                      << std::put_time(std::localtime(&time), "%F %T") << "  seed " << run.seed << std::endl;
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
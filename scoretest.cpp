@@ -0,0 +1,220 @@
+#include "ScoreStore.hpp"
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// Checks the score log's promises: runs submitted from many threads all reach the
+// log and come back in order of merit; a log torn by a crash or damaged in the
+// middle is cut back to its last good record, and appending carries on from there;
+// and a batch the disk refuses is counted as lost rather than reported as written,
+// and leaves nothing behind that a later open would bring back.
+//
+//   SnakeScoreTest [directory]
+
+namespace
+{
+    constexpr size_t Header = 16;
+    constexpr size_t Record = 40;
+
+    ScoreStore::Run MakeRun(uint32_t score, uint64_t seed)
+    {
+        ScoreStore::Run run{};
+        run.time = seed;
+        run.seed = seed;
+        run.score = score;
+        run.length = 5 + score;
+        run.ticks = 10 * score;
+        run.death = ScoreStore::Death::Body;
+        return run;
+    }
+
+    off_t SizeOf(const std::string& path)
+    {
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+    }
+
+    void Expect(bool condition, const std::string& what)
+    {
+        if (!condition)
+        {
+            throw std::runtime_error(what);
+        }
+    }
+
+    void Concurrent(const std::string& path)
+    {
+        constexpr uint32_t Threads = 4;
+        constexpr uint32_t Each = 200;
+
+        {
+            ScoreStore scores(path, 10);
+            std::vector<std::thread> threads;
+
+            for (uint32_t t = 0; t < Threads; t++)
+            {
+                threads.emplace_back([&scores, t]()
+                {
+                    for (uint32_t n = 0; n < Each; n++)
+                    {
+                        while (!scores.Submit(MakeRun(t * Each + n, t * Each + n)))
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            }
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            Expect(scores.Flush(), "Flush reported a lost run");
+            Expect(scores.Runs() == Threads * Each, "Not every run reached the log");
+        }
+
+        ScoreStore scores(path, 10);
+        auto top = scores.Top(3);
+        Expect(scores.Runs() == Threads * Each, "Reopening lost runs");
+        Expect(top.size() == 3 && top[0].score == Threads * Each - 1 && top[2].score == Threads * Each - 3, "Top is out of order");
+        Expect(SizeOf(path) == off_t(Header + Threads * Each * Record), "The log is not one record per run");
+    }
+
+    void Torn(const std::string& path)
+    {
+        {
+            ScoreStore scores(path);
+            for (uint32_t n = 0; n < 50; n++)
+            {
+                scores.Submit(MakeRun(n, n));
+            }
+        }
+
+        // A crash part way through the last record
+        Expect(truncate(path.c_str(), off_t(Header + 50 * Record - 7)) == 0, "truncate");
+        {
+            ScoreStore scores(path);
+            Expect(scores.Runs() == 49, "A torn record was kept");
+            Expect(SizeOf(path) == off_t(Header + 49 * Record), "The torn record was not cut off");
+            Expect(scores.Top(1)[0].score == 48, "The best whole run is missing");
+
+            scores.Submit(MakeRun(1000, 1000));
+            Expect(scores.Flush(), "Flush after recovery reported a lost run");
+        }
+
+        // A damaged record in the middle ends the log there
+        auto fd = open(path.c_str(), O_RDWR);
+        uint8_t byte = 0x5A;
+        Expect(pwrite(fd, &byte, 1, off_t(Header + 20 * Record + 12)) == 1, "pwrite");
+        close(fd);
+        {
+            ScoreStore scores(path);
+            Expect(scores.Runs() == 20, "Records after a damaged one were kept");
+            Expect(SizeOf(path) == off_t(Header + 20 * Record), "The log was not cut at the damaged record");
+        }
+
+        // Something else entirely is refused, not cut back
+        fd = open(path.c_str(), O_WRONLY | O_TRUNC);
+        Expect(write(fd, "not a score log at all", 22) == 22, "write");
+        close(fd);
+
+        try
+        {
+            ScoreStore scores(path);
+            throw std::logic_error("A file that is not a log was opened");
+        }
+        catch (std::runtime_error&)
+        {
+        }
+
+        Expect(SizeOf(path) == 22, "A file that is not a log was changed");
+
+        // So is one too short to hold a header
+        fd = open(path.c_str(), O_WRONLY | O_TRUNC);
+        Expect(write(fd, "notes\n", 6) == 6, "write");
+        close(fd);
+
+        try
+        {
+            ScoreStore scores(path);
+            throw std::logic_error("A short file that is not a log was opened");
+        }
+        catch (std::runtime_error&)
+        {
+        }
+
+        Expect(SizeOf(path) == 6, "A short file that is not a log was changed");
+    }
+
+    void Refused(const std::string& path)
+    {
+        std::signal(SIGXFSZ, SIG_IGN);
+        rlimit original;
+        getrlimit(RLIMIT_FSIZE, &original);
+
+        {
+            ScoreStore scores(path);
+            scores.Submit(MakeRun(1, 1));
+            Expect(scores.Flush(), "The first run was lost");
+
+            // Room for half a record more, so every batch from here is torn
+            rlimit limited = original;
+            limited.rlim_cur = Header + Record + Record / 2;
+            setrlimit(RLIMIT_FSIZE, &limited);
+
+            for (uint32_t n = 0; n < 10; n++)
+            {
+                scores.Submit(MakeRun(100 + n, 100 + n));
+            }
+
+            auto flushed = scores.Flush();
+            setrlimit(RLIMIT_FSIZE, &original);
+
+            Expect(!flushed, "Flush claimed a refused batch was written");
+            Expect(scores.Lost() == 10 && scores.FailedWrites() >= 1, "The refused runs were not counted");
+            Expect(scores.Runs() == 1 && scores.Top(1)[0].score == 1, "A refused run reached the index");
+            Expect(SizeOf(path) == off_t(Header + Record), "Part of the refused batch was left in the log");
+
+            scores.Submit(MakeRun(2, 2));
+            Expect(scores.Flush(), "Writing failed to carry on after a refused batch");
+        }
+
+        ScoreStore scores(path);
+        Expect(scores.Runs() == 2 && scores.Top(1)[0].score == 2, "Reopening brought back a refused run");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string directory = argc > 1 ? argv[1] : "/tmp";
+    auto path = directory + "/snake-scoretest-" + std::to_string(getpid()) + ".log";
+
+    try
+    {
+        for (auto test : {Concurrent, Torn, Refused})
+        {
+            unlink(path.c_str());
+            test(path);
+        }
+
+        unlink(path.c_str());
+    }
+    catch (std::exception& e)
+    {
+        unlink(path.c_str());
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "submitting, recovery and refused writes check out" << std::endl;
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include "Arguments.hpp"
+#include "Server.hpp"
+
+#include <csignal>
+#include <iostream>
+#include <memory>
+
+using SnakeServer = Server<256 / 3, 240 / 3>;
+
+static SnakeServer* server = nullptr;
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "/tmp/snake.sock";
+    uint64_t shards = std::max(1u, std::thread::hardware_concurrency());
+
+    // A server with no shards would return at once, serving nobody
+    if (argc > 3 || (argc > 1 && argv[1][0] == '-') || (argc > 2 && !ParseNumber(argv[2], shards, false)))
+    {
+        std::cerr << "Usage: " << argv[0] << " [socket] [shards]" << std::endl;
+        return 2;
+    }
+
+    // Outlives the try, so a signal after a failure still finds it
+    std::unique_ptr<SnakeServer> instance;
+
+    try
+    {
+        instance = std::make_unique<SnakeServer>(path, shards);
+        server = instance.get();
+
+        auto stop = [](int) { server->Stop(); };
+        std::signal(SIGINT, stop);
+        std::signal(SIGTERM, stop);
+
+        std::cout << "Serving on " << path << " with " << shards << " shards" << std::endl;
+        instance->Run();
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,298 @@
+#include "DeltaStream.hpp"
+#include "Server.hpp"
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Speaks the server's protocol as a client would: reads the greeting, follows the
+// stream from its keyframe, turns twice and starts a new game, and checks what it
+// rebuilds from the stream after every frame. Then starves a server of descriptors
+// to check that a shard that fails is reported by Run() rather than ending the
+// process, and that it leaves nothing open.
+//
+//   SnakeServerTest [socket]
+
+constexpr int Width = 24;
+constexpr int Height = 20;
+
+namespace
+{
+    class Client
+    {
+    public:
+        explicit Client(const std::string& path)
+        {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+            _socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (_socket < 0 || connect(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "connect " + path);
+            }
+
+            // A server that stops talking fails the test rather than hanging it
+            timeval timeout{2, 0};
+            setsockopt(_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        }
+
+        ~Client()
+        {
+            close(_socket);
+        }
+
+        void Send(uint8_t byte)
+        {
+            if (write(_socket, &byte, 1) != 1)
+            {
+                throw std::system_error(errno, std::generic_category(), "write");
+            }
+        }
+
+        // Reads until n bytes are buffered
+        const uint8_t* Need(size_t n)
+        {
+            while (_buffer.size() - _at < n)
+            {
+                uint8_t input[4096];
+                auto got = read(_socket, input, sizeof(input));
+
+                if (got <= 0)
+                {
+                    throw std::runtime_error("Server went quiet");
+                }
+
+                _buffer.insert(_buffer.end(), input, input + got);
+            }
+
+            return _buffer.data() + _at;
+        }
+
+        void Consume(size_t n)
+        {
+            _at += n;
+        }
+
+        // Decodes frames until until() holds, checking the state after each
+        void Follow(DeltaStream::Decoder<Width, Height>& decoder, const std::function<bool()>& until)
+        {
+            for (int frames = 0; frames < 1000; frames++)
+            {
+                size_t used;
+
+                while ((used = decoder.Decode(_buffer.data() + _at, _buffer.size() - _at)) == 0)
+                {
+                    Need(_buffer.size() - _at + 1);
+                }
+
+                Consume(used);
+                Check(decoder);
+
+                if (until())
+                {
+                    return;
+                }
+            }
+
+            throw std::runtime_error("Stream never got there");
+        }
+
+    private:
+        int _socket;
+        std::vector<uint8_t> _buffer;
+        size_t _at = 0;
+
+        static void Check(const DeltaStream::Decoder<Width, Height>& decoder)
+        {
+            if (!decoder.Synced())
+            {
+                return;
+            }
+
+            for (size_t n = 0; n < decoder.Length(); n++)
+            {
+                auto c = decoder.Body(n);
+
+                if (c.first < 0 || c.first >= Width || c.second < 0 || c.second >= Height)
+                {
+                    throw std::runtime_error("Body cell off the board at tick " + std::to_string(decoder.TickCount()));
+                }
+
+                if (n > 0 && std::abs(c.first - decoder.Body(n - 1).first) + std::abs(c.second - decoder.Body(n - 1).second) != 1)
+                {
+                    throw std::runtime_error("Body comes apart at tick " + std::to_string(decoder.TickCount()));
+                }
+            }
+        }
+    };
+
+    // Turns and waits for the head to take a step that way
+    void Turn(Client& client, DeltaStream::Decoder<Width, Height>& decoder, Direction direction, int dx, int dy)
+    {
+        client.Send(uint8_t(direction));
+        auto head = decoder.Body(0);
+
+        client.Follow(decoder, [&]()
+        {
+            auto now = decoder.Body(0);
+            auto moved = now != head;
+            auto step = std::make_pair(now.first - head.first, now.second - head.second);
+            head = now;
+
+            if (!decoder.Alive())
+            {
+                throw std::runtime_error("Snake died before it turned");
+            }
+
+            return moved && step == std::make_pair(dx, dy);
+        });
+    }
+
+    // The lowest descriptor free, which is the next one opened
+    int NextDescriptor()
+    {
+        auto fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        close(fd);
+        return fd;
+    }
+
+    size_t OpenDescriptors()
+    {
+        size_t count = 0;
+        auto* directory = opendir("/proc/self/fd");
+
+        while (directory && readdir(directory))
+        {
+            count++;
+        }
+
+        if (directory)
+        {
+            closedir(directory);
+        }
+
+        return count;
+    }
+
+    // Leaves room for fewer descriptors than the shards need, two each
+    bool ShardFailureIsReported(const std::string& path, size_t shards, int room)
+    {
+        Server<Width, Height> server(path, shards, std::chrono::milliseconds(20));
+        auto open = OpenDescriptors();
+        auto next = NextDescriptor();
+
+        rlimit original;
+        getrlimit(RLIMIT_NOFILE, &original);
+        rlimit limited = original;
+        limited.rlim_cur = rlim_t(next + room);
+        setrlimit(RLIMIT_NOFILE, &limited);
+
+        bool reported = false;
+
+        try
+        {
+            server.Run();
+        }
+        catch (std::system_error&)
+        {
+            reported = true;
+        }
+
+        setrlimit(RLIMIT_NOFILE, &original);
+        return reported && OpenDescriptors() == open;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string path = argc > 1 ? argv[1] : "/tmp/snake-test-" + std::to_string(getpid()) + ".sock";
+
+    try
+    {
+        Server<Width, Height> server(path, 2, std::chrono::milliseconds(20));
+        std::thread serving([&server]() { server.Run(); });
+
+        struct Stopper
+        {
+            Server<Width, Height>& server;
+            std::thread& thread;
+
+            ~Stopper()
+            {
+                server.Stop();
+                thread.join();
+            }
+        } stopper{server, serving};
+
+        Client client(path);
+        auto greeting = client.Need(5);
+
+        if (greeting[0] != 'H' || (greeting[1] | greeting[2] << 8) != Width || (greeting[3] | greeting[4] << 8) != Height)
+        {
+            std::cout << "bad greeting" << std::endl;
+            return 1;
+        }
+
+        client.Consume(5);
+
+        DeltaStream::Decoder<Width, Height> decoder;
+        client.Follow(decoder, [&]() { return decoder.Synced(); });
+
+        if (decoder.TickCount() != 0 || !decoder.Alive() || decoder.Length() == 0)
+        {
+            std::cout << "first keyframe is not a new game" << std::endl;
+            return 1;
+        }
+
+        // The snake starts heading north from the middle, so east then south keeps it clear of the border
+        Turn(client, decoder, Direction::East, 1, 0);
+        Turn(client, decoder, Direction::South, 0, 1);
+
+        auto ticks = decoder.TickCount();
+        client.Send('R');
+        client.Follow(decoder, [&]() { return decoder.TickCount() < ticks; });
+
+        if (decoder.TickCount() > 1 || !decoder.Alive())
+        {
+            std::cout << "restart did not start a new game" << std::endl;
+            return 1;
+        }
+    }
+    catch (std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        // One shard that fails part way through starting, then shards that fail
+        // while another is serving
+        if (!ShardFailureIsReported(path, 1, 1) || !ShardFailureIsReported(path, 3, 3))
+        {
+            std::cout << "a shard that failed went unreported or left descriptors open" << std::endl;
+            return 1;
+        }
+
+        std::cout << "greeting, keyframe, turns, restart and shard failure check out" << std::endl;
+        return 0;
+    }
+    catch (std::exception& e)
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+}
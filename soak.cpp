@@ -0,0 +1,423 @@
+#include "Arguments.hpp"
+#include "Game.hpp"
+#include "Hamiltonian.hpp"
+#include "WorkerPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Plays many seeded games on every core and checks the rules after every tick.
+// A game that breaks an invariant has its moves cut down to as few turns as still
+// break it, and is written out as a trace that --replay runs again.
+//
+//   SnakeSoak [games] [ticks] [first seed]
+//   SnakeSoak --replay <trace>
+
+using SoakGame = Game<256 / 3, 240 / 3>;
+
+namespace
+{
+    constexpr const char* Moves = "NESW";
+
+    // Games cycle through the inputs by seed: random turns, random turns that avoid
+    // blocked cells, and the Hamiltonian pilot, which lives the longest
+    enum class Input
+    {
+        Random,
+        Safe,
+        Hamiltonian
+    };
+
+    struct Failure
+    {
+        uint64_t seed;
+        std::string moves;
+        size_t tick;
+        std::string what;
+    };
+
+    uint64_t NextRandom(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    Coordinates Neighbour(const Coordinates& c, Direction direction)
+    {
+        switch (direction)
+        {
+            case Direction::North: return {c.first, c.second - 1};
+            case Direction::East:  return {c.first + 1, c.second};
+            case Direction::South: return {c.first, c.second + 1};
+            case Direction::West:  return {c.first - 1, c.second};
+        }
+
+        return c;
+    }
+
+    // Follows one game from tick to tick and reports the first rule it sees broken
+    class Checker
+    {
+    public:
+        Checker() :
+            _seen(SoakGame::Cells, 0),
+            _stamp(0)
+        {}
+
+        void Start(const SoakGame& game)
+        {
+            _length = game.Length();
+        }
+
+        // Returns what is wrong, or nothing
+        std::string Check(const SoakGame& game, bool alive)
+        {
+            auto length = _length;
+
+            for (auto& event : game.Events())
+            {
+                switch (event.type)
+                {
+                    case SoakGame::EventType::HeadAdded:    length++; break;
+                    case SoakGame::EventType::TailRemoved:  length--; break;
+                    case SoakGame::EventType::BodyAppended: length++; break;
+                    default: break;
+                }
+            }
+
+            if (length != game.Length())
+            {
+                return "events add up to length " + std::to_string(length) + " but it is " + std::to_string(game.Length());
+            }
+
+            _length = length;
+
+            // The snake starts at five and is owed one every ten ticks and five a meal
+            auto owed = 5 + (game.TickCount() + 9) / 10 + 5 * game.Score();
+            if (game.Length() + game.PendingGrowth() != owed)
+            {
+                return "length and growth do not add up to " + std::to_string(owed);
+            }
+
+            if (!alive)
+            {
+                // The head may be anywhere a collision allows
+                return {};
+            }
+
+            _stamp++;
+
+            for (size_t n = 0; n < game.Length(); n++)
+            {
+                auto c = game.Body(n);
+
+                if (!game.InBounds(c) || game.IsBorder(c.first, c.second))
+                {
+                    return "body cell " + Describe(c) + " is on or beyond the border";
+                }
+
+                if (n > 0 && std::abs(c.first - game.Body(n - 1).first) + std::abs(c.second - game.Body(n - 1).second) != 1)
+                {
+                    return "body cell " + Describe(c) + " does not touch the one before it";
+                }
+
+                if (_seen[Index(c)] == _stamp)
+                {
+                    return "body cell " + Describe(c) + " is taken twice";
+                }
+
+                _seen[Index(c)] = _stamp;
+            }
+
+            for (size_t n = 0; n < game.ObstacleCount(); n++)
+            {
+                auto c = game.Obstacle(n);
+
+                if (game.IsBorder(c.first, c.second))
+                {
+                    return "obstacle " + Describe(c) + " is on the border";
+                }
+
+                if (_seen[Index(c)] == _stamp)
+                {
+                    return "obstacle " + Describe(c) + " shares its cell with the body or another obstacle";
+                }
+
+                if (game.IsGood(c) == game.IsBad(c))
+                {
+                    return "obstacle " + Describe(c) + " is not exactly one of good or bad";
+                }
+
+                _seen[Index(c)] = _stamp;
+            }
+
+            if (game.TickCount() % 64 == 0)
+            {
+                for (int y = 0; y < SoakGame::Height(); y++)
+                {
+                    for (int x = 0; x < SoakGame::Width(); x++)
+                    {
+                        auto c = std::make_pair(x, y);
+
+                        if (game.Free().Test(c) == game.IsBlocked(c))
+                        {
+                            return "free cells disagree with the board at " + Describe(c);
+                        }
+                    }
+                }
+            }
+
+            return {};
+        }
+
+    private:
+        std::vector<uint32_t> _seen;
+        uint32_t _stamp;
+        size_t _length;
+
+        static size_t Index(const Coordinates& c)
+        {
+            return size_t(c.second * SoakGame::Width() + c.first);
+        }
+
+        static std::string Describe(const Coordinates& c)
+        {
+            return "(" + std::to_string(c.first) + ", " + std::to_string(c.second) + ")";
+        }
+    };
+
+    Direction Choose(const SoakGame& game, Input input, uint64_t& random)
+    {
+        auto r = NextRandom(random);
+
+        if (input == Input::Hamiltonian)
+        {
+            // Now and then a random turn, so the pilot has to recover
+            return r % 64 == 0 ? Direction(r >> 8 & 3) : Hamiltonian<SoakGame::Width(), SoakGame::Height()>::Steer(game);
+        }
+
+        if (r % 8 != 0)
+        {
+            return game.GetDirection();
+        }
+
+        auto direction = Direction(r >> 8 & 3);
+
+        if (input == Input::Safe)
+        {
+            for (int n = 0; n < 4 && game.IsBlocked(Neighbour(game.Head(), direction)); n++)
+            {
+                direction = Direction((int(direction) + 1) % 4);
+            }
+        }
+
+        return direction;
+    }
+
+    // Plays a game from its seed, choosing moves, or taking them from moves if it is
+    // not empty. Fills in the moves made, and the failure if there was one
+    bool Play(uint64_t seed, size_t ticks, std::string& moves, Checker& checker, Failure& failure)
+    {
+        bool replay = !moves.empty();
+        auto input = Input(seed % 3);
+        uint64_t random = seed;
+
+        SoakGame game;
+        game.Seed(seed);
+        checker.Start(game);
+
+        if (replay)
+        {
+            ticks = moves.size();
+        }
+        else
+        {
+            moves.clear();
+        }
+
+        for (size_t tick = 0; tick < ticks; tick++)
+        {
+            Direction direction;
+
+            if (replay)
+            {
+                direction = Direction(std::string(Moves).find(moves[tick]));
+            }
+            else
+            {
+                direction = Choose(game, input, random);
+                moves.push_back(Moves[int(direction)]);
+            }
+
+            game.SetDirection(direction);
+            auto alive = game.TryTick();
+            auto what = checker.Check(game, alive);
+
+            if (!what.empty())
+            {
+                moves.resize(tick + 1);
+                failure = {seed, moves, tick, what};
+                return false;
+            }
+
+            if (!alive)
+            {
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    // Turns that can be taken back without hiding the failure are taken back, until
+    // every turn left is needed
+    void Minimize(Failure& failure, Checker& checker)
+    {
+        auto moves = failure.moves;
+        bool shrunk = true;
+
+        while (shrunk)
+        {
+            shrunk = false;
+
+            for (size_t n = 0; n < moves.size(); n++)
+            {
+                auto straight = n == 0 ? 'N' : moves[n - 1];
+
+                if (moves[n] == straight)
+                {
+                    continue;
+                }
+
+                auto attempt = moves;
+                attempt[n] = straight;
+
+                for (auto m = n + 1; m < attempt.size() && moves[m] == moves[n]; m++)
+                {
+                    attempt[m] = straight;
+                }
+
+                Failure result;
+                if (!Play(failure.seed, 0, attempt, checker, result))
+                {
+                    moves = attempt.substr(0, result.tick + 1);
+                    failure = result;
+                    shrunk = true;
+                }
+            }
+        }
+    }
+
+    void Dump(const Failure& failure)
+    {
+        auto path = "soak-" + std::to_string(failure.seed) + ".trace";
+        std::ofstream out(path);
+        out << failure.seed << "\n" << failure.moves << "\n# tick " << failure.tick << ": " << failure.what << "\n";
+        std::cout << "seed " << failure.seed << " fails at tick " << failure.tick << ": " << failure.what
+                  << " (" << path << ")" << std::endl;
+    }
+
+    int Replay(const std::string& path)
+    {
+        std::ifstream in(path);
+        uint64_t seed;
+        std::string moves;
+
+        if (!(in >> seed >> moves))
+        {
+            std::cerr << "Could not read " << path << std::endl;
+            return 2;
+        }
+
+        Checker checker;
+        Failure failure;
+
+        if (Play(seed, 0, moves, checker, failure))
+        {
+            std::cout << "seed " << seed << " plays " << moves.size() << " ticks without a failure" << std::endl;
+            return 0;
+        }
+
+        std::cout << "seed " << seed << " fails at tick " << failure.tick << ": " << failure.what << std::endl;
+        return 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && std::string(argv[1]) == "--replay")
+    {
+        return Replay(argv[2]);
+    }
+
+    uint64_t games = 1000000;
+    uint64_t ticks = 5000;
+    uint64_t first = 1;
+
+    // A soak that quietly plays nothing would look like one that passed
+    if (argc > 4 || (argc > 1 && !ParseNumber(argv[1], games, false)) || (argc > 2 && !ParseNumber(argv[2], ticks, false)) ||
+        (argc > 3 && !ParseNumber(argv[3], first, true)))
+    {
+        std::cerr << "Usage: " << argv[0] << " [games] [ticks] [first seed]" << std::endl
+                  << "       " << argv[0] << " --replay <trace>" << std::endl;
+        return 2;
+    }
+
+    // Only the first few failures are minimized; the rest are counted
+    constexpr size_t MaxDumps = 10;
+
+    WorkerPool pool;
+    std::atomic<uint64_t> next(0);
+    std::atomic<uint64_t> played(0);
+    std::atomic<uint64_t> ticked(0);
+    std::atomic<size_t> failed(0);
+    std::mutex mutex;
+    std::vector<Failure> failures;
+
+    auto start = std::chrono::steady_clock::now();
+
+    pool.Run([&](size_t)
+    {
+        Checker checker;
+        std::string moves;
+
+        for (auto n = next.fetch_add(64); n < games; n = next.fetch_add(64))
+        {
+            for (auto seed = first + n; seed < first + std::min(games, n + 64); seed++)
+            {
+                Failure failure;
+                moves.clear();
+
+                if (!Play(seed, ticks, moves, checker, failure) && failed.fetch_add(1) < MaxDumps)
+                {
+                    Minimize(failure, checker);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    failures.push_back(failure);
+                }
+
+                played.fetch_add(1, std::memory_order_relaxed);
+                ticked.fetch_add(moves.size(), std::memory_order_relaxed);
+            }
+        }
+    });
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto& failure : failures)
+    {
+        Dump(failure);
+    }
+
+    std::cout << played << " games, " << ticked << " ticks in " << elapsed << " s on " << pool.Size()
+              << " threads, " << failed << " failed" << std::endl;
+
+    return failed ? 1 : 0;
+}
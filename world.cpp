@@ -0,0 +1,12 @@
+#include "WorldSnake.hpp"
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+    int width = argc > 1 ? std::atoi(argv[1]) : 16384;
+    int height = argc > 2 ? std::atoi(argv[2]) : width;
+
+    WorldSnake<256 / 3, 240 / 3, 4 * 3, 4 * 3> snake(width, height);
+    snake.Start();
+    return 0;
+}